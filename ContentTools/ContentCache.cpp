@@ -0,0 +1,195 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#include "ContentCache.h"
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+namespace zone::tools {
+namespace {
+
+// NOTE: each cache entry is one file called <hash>.bin in the cache directory:
+//			CacheEntryHeader	magic, tool version, hash and blob size
+//			blob				the output of packData()
+//		 Entries are written to a temporary file first and then renamed, so a crash or a
+//		 second editor never leaves a half written entry behind.
+constexpr uint32 cacheEntryMagic{ 'Z' | ('C' << 8) | ('C' << 16) | ('H' << 24) };
+
+struct CacheEntryHeader
+{
+	uint32					magic;
+	uint32					version;
+	uint64					hash;
+	uint64					size;
+};
+
+struct SceneHasher
+{
+	uint64					hash{ 0x9e3779b97f4a7c15ull };
+
+	void add(uint64 value)
+	{
+		hash ^= value * 0xff51afd7ed558ccdull;
+		hash = ((hash << 29) | (hash >> 35)) * 0xc4ceb9fe1a85ec53ull;
+	}
+
+	void add(float value)
+	{
+		uint32 bits;
+		memcpy(&bits, &value, sizeof(bits));
+		add((uint64)bits);
+	}
+
+	void add(const void* data, uint64 size)
+	{
+		const uint8* at{ (const uint8*)data };
+		add(size);
+		for (; size >= sizeof(uint64); size -= sizeof(uint64), at += sizeof(uint64))
+		{
+			uint64 value;
+			memcpy(&value, at, sizeof(value));
+			add(value);
+		}
+
+		if (size)
+		{
+			uint64 value{ 0 };
+			memcpy(&value, at, size);
+			add(value);
+		}
+	}
+
+	void add(const std::string& value) { add(value.data(), value.size()); }
+
+	template<typename T>
+	void add(const utl::vector<T>& values) { add(values.data(), values.size() * sizeof(T)); }
+
+	uint64 finish() const
+	{
+		uint64 value{ hash };
+		value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+		value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+		return value ^ (value >> 31);
+	}
+};
+
+	std::filesystem::path	cacheDirectory;
+	std::mutex				cacheMutex;
+
+std::filesystem::path getEntryPath(uint64 hash)
+{
+	char name[32];
+	sprintf_s(name, "%016llx.bin", (unsigned long long)hash);
+	std::lock_guard lock{ cacheMutex };
+	return cacheDirectory.empty() ? std::filesystem::path{} : cacheDirectory / name;
+}
+
+} // anonymous namespace
+
+uint64 hashScene(const Scene& scene, const GeometryImportSettings& settings)
+{
+	SceneHasher hasher{};
+	hasher.add((uint64)contentToolsVersion);
+	hasher.add(settings.smoothingAngle);
+	hasher.add((uint64)settings.calculateNormals);
+	hasher.add((uint64)settings.calculateTangents);
+	hasher.add((uint64)settings.reverseHandedness);
+	hasher.add((uint64)settings.importEmbededTextures);
+	hasher.add((uint64)settings.importAnimations);
+
+	hasher.add(scene.name);
+	hasher.add((uint64)scene.lodGroups.size());
+	for (const auto& lodGroup : scene.lodGroups)
+	{
+		hasher.add(lodGroup.name);
+		hasher.add((uint64)lodGroup.meshes.size());
+		for (const auto& mesh : lodGroup.meshes)
+		{
+			hasher.add(mesh.name);
+			hasher.add(mesh.lodThreshold);
+			hasher.add((uint64)mesh.lodID);
+			hasher.add(mesh.positions);
+			hasher.add(mesh.normals);
+			hasher.add(mesh.tangents);
+			hasher.add((uint64)mesh.uvSets.size());
+			for (const auto& uvSet : mesh.uvSets)
+			{
+				hasher.add(uvSet);
+			}
+			hasher.add(mesh.rawIndices);
+		}
+	}
+
+	return hasher.finish();
+}
+
+bool readCachedScene(uint64 hash, SceneData& data)
+{
+	const std::filesystem::path path{ getEntryPath(hash) };
+	if (path.empty()) return false;
+
+	std::ifstream file{ path, std::ios::binary };
+	if (!file) return false;
+
+	CacheEntryHeader header{};
+	if (!file.read((char*)&header, sizeof(header))) return false;
+	if (header.magic != cacheEntryMagic || header.version != contentToolsVersion ||
+		header.hash != hash || !header.size || header.size > uint32_invalid_id) return false;
+
+	uint8 *const buffer{ (uint8*)CoTaskMemAlloc(header.size) };
+	if (!buffer) return false;
+	// NOTE: the entry must end with the blob. A shorter or longer file is a broken entry.
+	if (!file.read((char*)buffer, header.size) || file.peek() != std::ifstream::traits_type::eof())
+	{
+		CoTaskMemFree(buffer);
+		return false;
+	}
+
+	data.buffer = buffer;
+	data.bufferSize = (uint32)header.size;
+	return true;
+}
+
+void writeCachedScene(uint64 hash, const SceneData& data)
+{
+	assert(data.buffer && data.bufferSize);
+	const std::filesystem::path path{ getEntryPath(hash) };
+	if (path.empty()) return;
+
+	std::filesystem::path temporaryPath{ path };
+	temporaryPath += '.' + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+	bool isWritten{ false };
+	{
+		std::ofstream file{ temporaryPath, std::ios::binary | std::ios::trunc };
+		if (!file) return;
+
+		const CacheEntryHeader header{ cacheEntryMagic, contentToolsVersion, hash, data.bufferSize };
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)data.buffer, data.bufferSize);
+		isWritten = (bool)file.flush();
+	}
+
+	std::error_code error{};
+	if (isWritten) std::filesystem::rename(temporaryPath, path, error);
+	if (!isWritten || error) std::filesystem::remove(temporaryPath, error);
+}
+
+// Sets the directory the packed scenes are cached in, e.g. one per project. The directory is
+// created if it doesn't exist. An empty path or null turns the cache off.
+EDITOR_INTERFACE void SetContentCacheDirectory(const char* path)
+{
+	std::filesystem::path directory{};
+	if (path && *path)
+	{
+		directory = path;
+		std::error_code error{};
+		std::filesystem::create_directories(directory, error);
+		if (error) directory.clear();
+	}
+
+	std::lock_guard lock{ cacheMutex };
+	cacheDirectory = directory;
+}
+
+}
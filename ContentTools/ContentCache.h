@@ -0,0 +1,21 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "Geometry.h"
+
+namespace zone::tools {
+
+// NOTE: bump this when processScene() or packData() change what they write, so that blobs
+//		 packed by an older version are not taken from the cache anymore.
+constexpr uint32 contentToolsVersion{ 1 };
+
+// Hash of the unprocessed meshes in 'scene', the import settings and the tool version.
+uint64 hashScene(const Scene& scene, const GeometryImportSettings& settings);
+
+// Fills 'data' with the packed blob stored under 'hash'. Returns false if there's no such
+// entry or no cache directory was set.
+bool readCachedScene(uint64 hash, SceneData& data);
+// Stores the packed blob in 'data' under 'hash'. Failing to write the cache is not an error.
+void writeCachedScene(uint64 hash, const SceneData& data);
+
+}
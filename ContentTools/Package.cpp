@@ -0,0 +1,115 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#include "Package.h"
+#include "..\Content\PackageFormat.h"
+#include "..\Utilities\Compression.h"
+#include <algorithm>
+
+namespace zone::tools {
+namespace {
+
+using namespace content;
+
+struct PackedBlock
+{
+	utl::vector<uint8>		data;
+	uint32					size;
+};
+
+uint32 getBlockCount(const PackageFile& file, uint32 blockSize)
+{
+	return (file.size + blockSize - 1) / blockSize;
+}
+
+} // anonymous namespace
+
+EDITOR_INTERFACE void PackFiles(PackageData* data)
+{
+	assert(data && (data->files || !data->fileCount));
+	const uint32 blockSize{ data->blockSize ? data->blockSize : package_default_block_size };
+	assert(blockSize >= package_min_block_size && blockSize <= package_max_block_size);
+
+	// The directory is sorted by name hash, so that the engine can binary search it.
+	utl::vector<uint32> order(data->fileCount);
+	for (uint32 i{ 0 }; i < data->fileCount; ++i) order[i] = i;
+	std::sort(order.begin(), order.end(), [data](uint32 a, uint32 b)
+		{
+			return hash_package_name(data->files[a].name) < hash_package_name(data->files[b].name);
+		});
+
+	uint32 blockCount{ 0 };
+	for (uint32 i{ 0 }; i < data->fileCount; ++i)
+	{
+		blockCount += getBlockCount(data->files[i], blockSize);
+	}
+
+	// Compress every block, keeping the ones that didn't get smaller as they are.
+	utl::vector<PackedBlock> blocks(blockCount);
+	utl::vector<uint8> scratch(utl::lz_compress_bound(blockSize));
+	uint32 blockIndex{ 0 };
+	for (uint32 i{ 0 }; i < data->fileCount; ++i)
+	{
+		const PackageFile& file{ data->files[order[i]] };
+		for (uint32 offset{ 0 }; offset < file.size; offset += blockSize, ++blockIndex)
+		{
+			const uint32 size{ file.size - offset < blockSize ? file.size - offset : blockSize };
+			const uint8* const source{ file.data + offset };
+			const uint64 compressedSize{ utl::lz_compress(source, size, scratch.data(), size - 1) };
+			PackedBlock& block{ blocks[blockIndex] };
+			block.size = size;
+			if (compressedSize)
+			{
+				block.data.resize(compressedSize);
+				memcpy(block.data.data(), scratch.data(), compressedSize);
+			}
+			else
+			{
+				block.data.resize(size);
+				memcpy(block.data.data(), source, size);
+			}
+		}
+	}
+	assert(blockIndex == blockCount);
+
+	uint64 packageSize{ sizeof(package_header) + data->fileCount * sizeof(package_file) + blockCount * sizeof(package_block) };
+	for (uint32 i{ 0 }; i < blockCount; ++i) packageSize += blocks[i].data.size();
+	assert(packageSize <= uint32_invalid_id);
+
+	data->bufferSize = static_cast<uint32>(packageSize);
+	data->buffer = static_cast<uint8*>(CoTaskMemAlloc(packageSize));
+	assert(data->buffer);
+	uint8* const buffer{ data->buffer };
+
+	package_header header{};
+	header.magic = package_magic;
+	header.version = package_version;
+	header.block_size = blockSize;
+	header.file_count = data->fileCount;
+	header.block_count = blockCount;
+	memcpy(buffer, &header, sizeof(header));
+
+	package_file* const files{ (package_file*)(buffer + sizeof(package_header)) };
+	package_block* const blockTable{ (package_block*)(files + data->fileCount) };
+	uint64 at{ (uint64)((uint8*)(blockTable + blockCount) - buffer) };
+
+	blockIndex = 0;
+	for (uint32 i{ 0 }; i < data->fileCount; ++i)
+	{
+		const PackageFile& file{ data->files[order[i]] };
+		const uint32 fileBlockCount{ getBlockCount(file, blockSize) };
+		files[i] = { hash_package_name(file.name), file.size, blockIndex, fileBlockCount };
+		// Two files with the same name (or a hash collision).
+		assert(!i || files[i - 1].name_hash != files[i].name_hash);
+
+		for (uint32 b{ 0 }; b < fileBlockCount; ++b, ++blockIndex)
+		{
+			const PackedBlock& block{ blocks[blockIndex] };
+			blockTable[blockIndex] = { at, static_cast<uint32>(block.data.size()), block.size };
+			memcpy(&buffer[at], block.data.data(), block.data.size()); at += block.data.size();
+		}
+	}
+
+	assert(at == packageSize);
+}
+
+}
@@ -0,0 +1,25 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "ToolsCommon.h"
+
+namespace zone::tools {
+
+struct PackageFile
+{
+	const char*				name;
+	const uint8*			data;
+	uint32					size;
+};
+
+struct PackageData
+{
+	PackageFile*			files;
+	uint32					fileCount;
+	// Block size in bytes, from 64 KB to 256 KB. 0 uses the default block size.
+	uint32					blockSize;
+	uint8*					buffer;
+	uint32					bufferSize;
+};
+
+}
@@ -2,6 +2,7 @@
 // Distributed under the MIT license. See the LICENSE file in the project root for more information.
 #include "PrimitiveMesh.h"
 #include "Geometry.h"
+#include "ContentCache.h"
 namespace zone::tools {
 namespace {
 using namespace math;
@@ -273,8 +274,13 @@ EDITOR_INTERFACE void CreatePrimitiveMesh(SceneData* data, PrimitiveInitInfo* in
 	creators[info->type](scene, *info);
 	
 	data->settings.calculateNormals = 1;
+	// NOTE: the hash is taken before processing, so a hit skips processScene() and packData().
+	const uint64 hash{ hashScene(scene, data->settings) };
+	if (readCachedScene(hash, *data)) return;
+
 	processScene(scene, data->settings);
 	packData(scene, *data);
+	writeCachedScene(hash, *data);
 }
 
 
@@ -0,0 +1,830 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#include "Bounds.h"
+#include "Entity.h"
+#include "Transform.h"
+#include "..\Core\JobSystem.h"
+#include "..\Utilities\FreeList.h"
+#include <cmath>
+#include <algorithm>
+
+namespace zone::bounds {
+
+namespace {
+
+// NOTE: bounds of dynamic entities live in a dynamic AABB tree: every leaf holds a "fat" box,
+//		 the world box grown by a margin and by the last displacement. A bounds only needs
+//		 to be reinserted when its world box leaves its fat box, so slow and small movements
+//		 cost just a containment test. The tree is kept balanced with rotations while
+//		 inserting and removing leaves.
+//		 Bounds of static entities go into a separate tree with tight boxes. It's built in
+//		 one go when static entities are loaded and never touched by per-frame updates.
+struct bvh_node
+{
+	aabb		box;
+	uint32		parent;
+	uint32		left;
+	uint32		right;
+	// Bounds index for leaves, invalid for internal nodes.
+	uint32		item;
+	uint32		height;
+};
+
+constexpr float fat_margin{ 0.1f };
+constexpr float displacement_multiplier{ 4.f };
+constexpr uint32 max_refit_levels{ 4 };
+constexpr uint32 max_stack_depth{ 256 };
+constexpr uint32 min_parallel_count{ 16 * 1024 };
+constexpr uint32 min_batch_size{ 4 * 1024 };
+constexpr uint32 min_parallel_rays{ 256 };
+constexpr uint32 min_ray_batch_size{ 64 };
+// Leaf index of a static bounds that is waiting to be added to the static tree.
+constexpr uint32 queued_leaf{ uint32_invalid_id - 1 };
+
+utl::vector<math::Vec3F>			local_centers;
+utl::vector<math::Vec3F>			local_extents;
+utl::vector<aabb>					world_bounds;
+utl::vector<uint32>					leaves;
+utl::vector<game_entity::entity>	owners;
+
+// Bounds that were created or changed outside of a transform change.
+utl::vector<uint32>					pending_ids;
+// Scratch lists for update(), kept around to avoid allocations each frame.
+utl::vector<uint32>					update_ids;
+utl::vector<aabb>					new_bounds;
+
+utl::vector<uint32>					new_static_ids;
+
+struct bvh
+{
+	utl::FreeList<bvh_node>		nodes;
+	uint32						root{ uint32_invalid_id };
+};
+
+bvh									dynamic_tree;
+bvh									static_tree;
+
+bool is_leaf(const bvh_node& node)
+{
+	return node.item != uint32_invalid_id;
+}
+
+aabb combine(const aabb& a, const aabb& b)
+{
+	aabb result;
+	result.min = { a.min.x < b.min.x ? a.min.x : b.min.x, a.min.y < b.min.y ? a.min.y : b.min.y, a.min.z < b.min.z ? a.min.z : b.min.z };
+	result.max = { a.max.x > b.max.x ? a.max.x : b.max.x, a.max.y > b.max.y ? a.max.y : b.max.y, a.max.z > b.max.z ? a.max.z : b.max.z };
+	return result;
+}
+
+bool contains(const aabb& outer, const aabb& inner)
+{
+	return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+		   outer.max.x >= inner.max.x && outer.max.y >= inner.max.y && outer.max.z >= inner.max.z;
+}
+
+bool overlaps(const aabb& a, const aabb& b)
+{
+	return a.min.x <= b.max.x && a.min.y <= b.max.y && a.min.z <= b.max.z &&
+		   a.max.x >= b.min.x && a.max.y >= b.min.y && a.max.z >= b.min.z;
+}
+
+bool overlaps(const aabb& box, const sphere& s)
+{
+	auto distance = [](float v, float min, float max) { return v < min ? min - v : (v > max ? v - max : 0.f); };
+	const float dx{ distance(s.center.x, box.min.x, box.max.x) };
+	const float dy{ distance(s.center.y, box.min.y, box.max.y) };
+	const float dz{ distance(s.center.z, box.min.z, box.max.z) };
+	return dx * dx + dy * dy + dz * dz <= s.radius * s.radius;
+}
+
+// Conservative: only rejects boxes that are fully outside one of the planes.
+bool overlaps(const aabb& box, const frustum& f)
+{
+	for (uint32 i{ 0 }; i < 6; ++i)
+	{
+		const math::Vec4F& p{ f.planes[i] };
+		const float x{ p.x >= 0.f ? box.max.x : box.min.x };
+		const float y{ p.y >= 0.f ? box.max.y : box.min.y };
+		const float z{ p.z >= 0.f ? box.max.z : box.min.z };
+		if (p.x * x + p.y * y + p.z * z + p.w < 0.f) return false;
+	}
+	return true;
+}
+
+// Returns the entry distance of the ray into the box, or a negative value when it misses.
+float intersect(const aabb& box, const math::Vec3F& origin, const math::Vec3F& inv_direction, float max_distance)
+{
+	float t_min{ 0.f };
+	float t_max{ max_distance };
+	const float o[3]{ origin.x, origin.y, origin.z };
+	const float d[3]{ inv_direction.x, inv_direction.y, inv_direction.z };
+	const float lo[3]{ box.min.x, box.min.y, box.min.z };
+	const float hi[3]{ box.max.x, box.max.y, box.max.z };
+	for (uint32 i{ 0 }; i < 3; ++i)
+	{
+		float t0{ (lo[i] - o[i]) * d[i] };
+		float t1{ (hi[i] - o[i]) * d[i] };
+		if (t0 > t1) { const float t{ t0 }; t0 = t1; t1 = t; }
+		// NOTE: a NaN from 0 * inf (origin on a slab plane, axis-parallel ray) fails these
+		//		 comparisons and leaves the interval as it was.
+		t_min = t0 > t_min ? t0 : t_min;
+		t_max = t1 < t_max ? t1 : t_max;
+		if (t_min > t_max) return -1.f;
+	}
+	return t_min;
+}
+
+float surface_area(const aabb& box)
+{
+	const float dx{ box.max.x - box.min.x };
+	const float dy{ box.max.y - box.min.y };
+	const float dz{ box.max.z - box.min.z };
+	return 2.f * (dx * dy + dy * dz + dz * dx);
+}
+
+aabb compute_world_bounds(const math::Vec3F& c, const math::Vec3F& e, const math::Mat3x4F& m)
+{
+	math::Vec3F center, extents;
+	center.x = m.m[0][0] * c.x + m.m[0][1] * c.y + m.m[0][2] * c.z + m.m[0][3];
+	center.y = m.m[1][0] * c.x + m.m[1][1] * c.y + m.m[1][2] * c.z + m.m[1][3];
+	center.z = m.m[2][0] * c.x + m.m[2][1] * c.y + m.m[2][2] * c.z + m.m[2][3];
+	extents.x = fabsf(m.m[0][0]) * e.x + fabsf(m.m[0][1]) * e.y + fabsf(m.m[0][2]) * e.z;
+	extents.y = fabsf(m.m[1][0]) * e.x + fabsf(m.m[1][1]) * e.y + fabsf(m.m[1][2]) * e.z;
+	extents.z = fabsf(m.m[2][0]) * e.x + fabsf(m.m[2][1]) * e.y + fabsf(m.m[2][2]) * e.z;
+	return { { center.x - extents.x, center.y - extents.y, center.z - extents.z },
+			 { center.x + extents.x, center.y + extents.y, center.z + extents.z } };
+}
+
+// Grows 'box' by the margin and stretches it in the direction of 'displacement', so that an
+// object moving at a steady speed stays inside its fat box for a few frames.
+aabb compute_fat_bounds(const aabb& box, const math::Vec3F& displacement)
+{
+	aabb fat{ { box.min.x - fat_margin, box.min.y - fat_margin, box.min.z - fat_margin },
+			  { box.max.x + fat_margin, box.max.y + fat_margin, box.max.z + fat_margin } };
+	const float d[3]{ displacement.x * displacement_multiplier, displacement.y * displacement_multiplier, displacement.z * displacement_multiplier };
+	float *const min[3]{ &fat.min.x, &fat.min.y, &fat.min.z };
+	float *const max[3]{ &fat.max.x, &fat.max.y, &fat.max.z };
+	for (uint32 i{ 0 }; i < 3; ++i)
+	{
+		if (d[i] < 0.f) *min[i] += d[i];
+		else *max[i] += d[i];
+	}
+	return fat;
+}
+
+void update_node(bvh& tree, uint32 index)
+{
+	bvh_node& node{ tree.nodes[index] };
+	const bvh_node& left{ tree.nodes[node.left] };
+	const bvh_node& right{ tree.nodes[node.right] };
+	node.box = combine(left.box, right.box);
+	node.height = 1 + (left.height > right.height ? left.height : right.height);
+}
+
+void replace_child(bvh& tree, uint32 parent, uint32 old_child, uint32 new_child)
+{
+	if (parent == uint32_invalid_id)
+	{
+		tree.root = new_child;
+		return;
+	}
+
+	bvh_node& node{ tree.nodes[parent] };
+	if (node.left == old_child) node.left = new_child;
+	else node.right = new_child;
+}
+
+// Rotates the taller grandchild of 'a' up when the heights of its children differ by more
+// than 1. Returns the index of the node that took the place of 'a'.
+uint32 balance(bvh& tree, uint32 a)
+{
+	bvh_node& node_a{ tree.nodes[a] };
+	if (is_leaf(node_a) || node_a.height < 2) return a;
+
+	const uint32 b{ node_a.left };
+	const uint32 c{ node_a.right };
+	bvh_node& node_b{ tree.nodes[b] };
+	bvh_node& node_c{ tree.nodes[c] };
+	const int32 difference{ (int32)node_c.height - (int32)node_b.height };
+
+	// NOTE: 'up' takes the place of 'a', 'a' takes the shorter child of 'up' and 'up'
+	//		 keeps its taller child.
+	auto rotate = [&tree, a, &node_a](uint32 up, bvh_node& node_up, bool up_is_right)
+	{
+		const uint32 f{ node_up.left };
+		const uint32 g{ node_up.right };
+		const bool f_taller{ tree.nodes[f].height > tree.nodes[g].height };
+		const uint32 taller{ f_taller ? f : g };
+		const uint32 shorter{ f_taller ? g : f };
+
+		node_up.left = a;
+		node_up.right = taller;
+		node_up.parent = node_a.parent;
+		node_a.parent = up;
+		replace_child(tree, node_up.parent, a, up);
+
+		if (up_is_right) node_a.right = shorter;
+		else node_a.left = shorter;
+		tree.nodes[shorter].parent = a;
+
+		update_node(tree, a);
+		update_node(tree, up);
+	};
+
+	if (difference > 1)
+	{
+		rotate(c, node_c, true);
+		return c;
+	}
+
+	if (difference < -1)
+	{
+		rotate(b, node_b, false);
+		return b;
+	}
+
+	return a;
+}
+
+bool is_same(const aabb& a, const aabb& b)
+{
+	return a.min.x == b.min.x && a.min.y == b.min.y && a.min.z == b.min.z &&
+		   a.max.x == b.max.x && a.max.y == b.max.y && a.max.z == b.max.z;
+}
+
+// Balances and recomputes 'index' and its ancestors. 'index' is the node whose children changed.
+void refit_ancestors(bvh& tree, uint32 index)
+{
+	bool is_first{ true };
+	while (index != uint32_invalid_id)
+	{
+		const uint32 subtree{ balance(tree, index) };
+		bvh_node& node{ tree.nodes[subtree] };
+		const aabb old_box{ node.box };
+		const uint32 old_height{ node.height };
+		update_node(tree, subtree);
+
+		// NOTE: a node that came out unchanged can't change anything further up.
+		if (!is_first && subtree == index && old_height == node.height && is_same(old_box, node.box)) break;
+
+		is_first = false;
+		index = node.parent;
+	}
+}
+
+void insert_leaf(bvh& tree, uint32 leaf)
+{
+	if (tree.root == uint32_invalid_id)
+	{
+		tree.root = leaf;
+		tree.nodes[leaf].parent = uint32_invalid_id;
+		return;
+	}
+
+	// NOTE: walk down to the sibling that minimizes the total surface area of the tree.
+	//		 Enlarging an internal node adds its surface increase to every level below.
+	const aabb leaf_box{ tree.nodes[leaf].box };
+	uint32 index{ tree.root };
+	while (!is_leaf(tree.nodes[index]))
+	{
+		const bvh_node& node{ tree.nodes[index] };
+		const float area{ surface_area(node.box) };
+		const float combined_area{ surface_area(combine(node.box, leaf_box)) };
+		const float cost{ 2.f * combined_area };
+		const float inheritance_cost{ 2.f * (combined_area - area) };
+
+		auto child_cost = [&](uint32 child)
+		{
+			const bvh_node& child_node{ tree.nodes[child] };
+			const float new_area{ surface_area(combine(child_node.box, leaf_box)) };
+			return is_leaf(child_node) ? new_area + inheritance_cost : new_area - surface_area(child_node.box) + inheritance_cost;
+		};
+
+		const float left_cost{ child_cost(node.left) };
+		const float right_cost{ child_cost(node.right) };
+		if (cost < left_cost && cost < right_cost) break;
+		index = left_cost < right_cost ? node.left : node.right;
+	}
+
+	const uint32 sibling{ index };
+	const uint32 new_parent{ tree.nodes.add() };
+	const uint32 old_parent{ tree.nodes[sibling].parent };
+
+	bvh_node& parent_node{ tree.nodes[new_parent] };
+	parent_node.parent = old_parent;
+	parent_node.left = sibling;
+	parent_node.right = leaf;
+	parent_node.item = uint32_invalid_id;
+	parent_node.box = combine(tree.nodes[sibling].box, leaf_box);
+	parent_node.height = tree.nodes[sibling].height + 1;
+	replace_child(tree, old_parent, sibling, new_parent);
+	tree.nodes[sibling].parent = new_parent;
+	tree.nodes[leaf].parent = new_parent;
+
+	refit_ancestors(tree, new_parent);
+}
+
+void remove_leaf(bvh& tree, uint32 leaf)
+{
+	if (leaf == tree.root)
+	{
+		tree.root = uint32_invalid_id;
+		return;
+	}
+
+	const uint32 parent{ tree.nodes[leaf].parent };
+	const uint32 grand_parent{ tree.nodes[parent].parent };
+	const uint32 sibling{ tree.nodes[parent].left == leaf ? tree.nodes[parent].right : tree.nodes[parent].left };
+
+	replace_child(tree, grand_parent, parent, sibling);
+	tree.nodes[sibling].parent = grand_parent;
+	tree.nodes.remove(parent);
+
+	refit_ancestors(tree, grand_parent);
+}
+
+// Tries to give 'leaf' a new box without changing the shape of the tree. Succeeds when one of
+// the first few ancestors still contains the new box, in which case only the boxes below that
+// ancestor have to be recomputed. Reinserting the leaf costs a full walk down and up the tree,
+// this stays within a handful of nodes that are likely to be in cache.
+bool refit_leaf(bvh& tree, uint32 leaf, const aabb& fat_box)
+{
+	uint32 ancestor{ tree.nodes[leaf].parent };
+	uint32 level{ 0 };
+	while (ancestor != uint32_invalid_id && !contains(tree.nodes[ancestor].box, fat_box))
+	{
+		if (++level == max_refit_levels) return false;
+		ancestor = tree.nodes[ancestor].parent;
+	}
+
+	if (ancestor == uint32_invalid_id) return false;
+
+	tree.nodes[leaf].box = fat_box;
+	for (uint32 index{ tree.nodes[leaf].parent }; index != ancestor; index = tree.nodes[index].parent)
+	{
+		tree.nodes[index].box = combine(tree.nodes[tree.nodes[index].left].box, tree.nodes[tree.nodes[index].right].box);
+	}
+	return true;
+}
+
+uint32 create_leaf(bvh& tree, uint32 item, const aabb& fat_box)
+{
+	const uint32 leaf{ tree.nodes.add() };
+	bvh_node& node{ tree.nodes[leaf] };
+	node.box = fat_box;
+	node.left = uint32_invalid_id;
+	node.right = uint32_invalid_id;
+	node.item = item;
+	node.height = 0;
+	insert_leaf(tree, leaf);
+	return leaf;
+}
+
+void compute_new_bounds(uint32 begin, uint32 end, void*)
+{
+	const math::Mat3x4F *const world_matrices{ transform::get_world_matrices() };
+	for (uint32 i{ begin }; i < end; ++i)
+	{
+		const uint32 index{ update_ids[i] };
+		new_bounds[i] = compute_world_bounds(local_centers[index], local_extents[index], world_matrices[index]);
+	}
+}
+
+// Calls 'func(item)' for every bounds whose world box passes 'test'. Subtrees are skipped
+// when their fat box fails 'test'.
+template<typename test_func, typename result_func>
+void traverse(bvh& tree, test_func test, result_func func)
+{
+	if (tree.root == uint32_invalid_id) return;
+
+	uint32 stack[max_stack_depth];
+	uint32 top{ 0 };
+	stack[top++] = tree.root;
+	while (top)
+	{
+		const bvh_node& node{ tree.nodes[stack[--top]] };
+		if (!test(node.box)) continue;
+
+		if (is_leaf(node))
+		{
+			if (test(world_bounds[node.item])) func(node.item);
+		}
+		else
+		{
+			assert(top + 2 <= max_stack_depth);
+			stack[top++] = node.left;
+			stack[top++] = node.right;
+		}
+	}
+}
+
+float center(uint32 item, uint32 axis)
+{
+	const aabb& box{ world_bounds[item] };
+	return (&box.min.x)[axis] + (&box.max.x)[axis];
+}
+
+// Builds a subtree over 'items' top-down, splitting at the median of the box centers along
+// their longest axis. Much faster than inserting the leaves one by one and gives a tree
+// with better queries.
+uint32 build_subtree(bvh& tree, uint32 *const items, uint32 count, uint32 parent)
+{
+	assert(count);
+	if (count == 1)
+	{
+		const uint32 leaf{ tree.nodes.add() };
+		bvh_node& node{ tree.nodes[leaf] };
+		node.box = world_bounds[items[0]];
+		node.parent = parent;
+		node.left = uint32_invalid_id;
+		node.right = uint32_invalid_id;
+		node.item = items[0];
+		node.height = 0;
+		leaves[items[0]] = leaf;
+		return leaf;
+	}
+
+	float min[3]{ center(items[0], 0), center(items[0], 1), center(items[0], 2) };
+	float max[3]{ min[0], min[1], min[2] };
+	for (uint32 i{ 1 }; i < count; ++i)
+	{
+		for (uint32 axis{ 0 }; axis < 3; ++axis)
+		{
+			const float c{ center(items[i], axis) };
+			min[axis] = c < min[axis] ? c : min[axis];
+			max[axis] = c > max[axis] ? c : max[axis];
+		}
+	}
+
+	uint32 axis{ 0 };
+	if (max[1] - min[1] > max[axis] - min[axis]) axis = 1;
+	if (max[2] - min[2] > max[axis] - min[axis]) axis = 2;
+
+	const uint32 half{ count / 2 };
+	std::nth_element(items, items + half, items + count, [axis](uint32 a, uint32 b) { return center(a, axis) < center(b, axis); });
+
+	const uint32 index{ tree.nodes.add() };
+	const uint32 left{ build_subtree(tree, items, half, index) };
+	const uint32 right{ build_subtree(tree, items + half, count - half, index) };
+	bvh_node& node{ tree.nodes[index] };
+	node.parent = parent;
+	node.left = left;
+	node.right = right;
+	node.item = uint32_invalid_id;
+	update_node(tree, index);
+	return index;
+}
+
+bvh& tree_of(uint32 index)
+{
+	return transform::component{ transform::transform_id{ index } }.is_static() ? static_tree : dynamic_tree;
+}
+
+template<typename T>
+void run_queries(const T *const queries, uint32 count, utl::vector<component>& results, utl::vector<uint32>& offsets)
+{
+	assert(queries || !count);
+	results.clear();
+	offsets.resize(count + 1);
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		offsets[i] = (uint32)results.size();
+		const T& query{ queries[i] };
+		auto test = [&query](const aabb& box) { return overlaps(box, query); };
+		auto add = [&results](uint32 item) { results.emplace_back(bounds_id{ item }); };
+		traverse(static_tree, test, add);
+		traverse(dynamic_tree, test, add);
+	}
+	offsets[count] = (uint32)results.size();
+}
+
+// Updates 'hit' when the closest hit in 'tree' is closer than 'hit'.
+void cast_ray(bvh& tree, const ray& r, ray_hit& hit)
+{
+	if (tree.root == uint32_invalid_id) return;
+
+	// NOTE: IEEE division gives +/-inf for zero components, which the slab test handles.
+	const math::Vec3F inv_direction{ 1.f / r.direction.x, 1.f / r.direction.y, 1.f / r.direction.z };
+	float closest{ hit.bounds.is_valid() ? hit.distance : r.max_distance };
+
+	uint32 stack[max_stack_depth];
+	uint32 top{ 0 };
+	stack[top++] = tree.root;
+	while (top)
+	{
+		const bvh_node& node{ tree.nodes[stack[--top]] };
+		if (intersect(node.box, r.origin, inv_direction, closest) < 0.f) continue;
+
+		if (is_leaf(node))
+		{
+			const float distance{ intersect(world_bounds[node.item], r.origin, inv_direction, closest) };
+			if (distance >= 0.f)
+			{
+				closest = distance;
+				hit.bounds = component{ bounds_id{ node.item } };
+				hit.distance = distance;
+			}
+		}
+		else
+		{
+			// NOTE: push the farther child first, so the nearer one is visited first and
+			//		 shrinks 'closest' early.
+			const float left{ intersect(tree.nodes[node.left].box, r.origin, inv_direction, closest) };
+			const float right{ intersect(tree.nodes[node.right].box, r.origin, inv_direction, closest) };
+			assert(top + 2 <= max_stack_depth);
+			if (left >= 0.f && right >= 0.f)
+			{
+				const bool left_first{ left <= right };
+				stack[top++] = left_first ? node.right : node.left;
+				stack[top++] = left_first ? node.left : node.right;
+			}
+			else if (left >= 0.f) stack[top++] = node.left;
+			else if (right >= 0.f) stack[top++] = node.right;
+		}
+	}
+}
+
+struct raycast_context
+{
+	const ray*	rays;
+	ray_hit*	hits;
+};
+
+void cast_rays(uint32 begin, uint32 end, void* context)
+{
+	const raycast_context& ctx{ *(const raycast_context*)context };
+	for (uint32 i{ begin }; i < end; ++i)
+	{
+		ray_hit hit{};
+		cast_ray(static_tree, ctx.rays[i], hit);
+		cast_ray(dynamic_tree, ctx.rays[i], hit);
+		ctx.hits[i] = hit;
+	}
+}
+
+bool exists(uint32 index)
+{
+	return index < owners.size() && owners[index].is_valid();
+}
+
+// Removes all nodes of a tree.
+void clear_tree(bvh& tree)
+{
+	if (tree.root == uint32_invalid_id) return;
+
+	utl::vector<uint32> stack{};
+	stack.emplace_back(tree.root);
+	while (stack.size())
+	{
+		const uint32 index{ stack[stack.size() - 1] };
+		stack.erase(stack.size() - 1);
+		const bvh_node& node{ tree.nodes[index] };
+		if (!is_leaf(node))
+		{
+			stack.emplace_back(node.left);
+			stack.emplace_back(node.right);
+		}
+		tree.nodes.remove(index);
+	}
+	tree.root = uint32_invalid_id;
+}
+
+} // anonymous namespace
+
+component create(init_info info, game_entity::entity entity)
+{
+	assert(entity.is_valid());
+	const id::id_type entity_index{ id::index(entity.get_id()) };
+
+	if (owners.size() > entity_index)
+	{
+		assert(!owners[entity_index].is_valid());
+		local_centers[entity_index] = math::Vec3F(info.center);
+		local_extents[entity_index] = math::Vec3F(info.extents);
+		owners[entity_index] = entity;
+	}
+	else
+	{
+		// NOTE: bounds are indexed by entity, fill the slots of entities without bounds.
+		while (owners.size() <= entity_index)
+		{
+			local_centers.emplace_back();
+			local_extents.emplace_back();
+			world_bounds.emplace_back();
+			leaves.emplace_back(uint32_invalid_id);
+			owners.emplace_back();
+		}
+		local_centers[entity_index] = math::Vec3F(info.center);
+		local_extents[entity_index] = math::Vec3F(info.extents);
+		owners[entity_index] = entity;
+	}
+
+	// NOTE: the world matrix of a new transform isn't known until the next update, so the
+	//		 bounds is added to the BVH then.
+	pending_ids.emplace_back(entity_index);
+	return component{ bounds_id{ entity_index } };
+}
+
+void remove(component _component)
+{
+	assert(_component.is_valid());
+	const id::id_type index{ id::index(_component.get_id()) };
+	assert(exists(index));
+	if (leaves[index] != uint32_invalid_id)
+	{
+		bvh& tree{ tree_of(index) };
+		remove_leaf(tree, leaves[index]);
+		tree.nodes.remove(leaves[index]);
+		leaves[index] = uint32_invalid_id;
+	}
+	owners[index] = game_entity::entity{};
+}
+
+void update()
+{
+	update_ids.clear();
+	const transform::transform_id *const changed_ids{ transform::get_changed_ids() };
+	const uint32 num_changed{ transform::changed_count() };
+	for (uint32 i{ 0 }; i < num_changed; ++i)
+	{
+		const uint32 index{ id::index(changed_ids[i]) };
+		if (exists(index)) update_ids.emplace_back(index);
+	}
+	for (uint32 i{ 0 }; i < pending_ids.size(); ++i)
+	{
+		if (exists(pending_ids[i])) update_ids.emplace_back(pending_ids[i]);
+	}
+	pending_ids.clear();
+
+	const uint32 count{ (uint32)update_ids.size() };
+	if (!count) return;
+
+	new_bounds.resize(count);
+	if (count < min_parallel_count)
+	{
+		compute_new_bounds(0, count, nullptr);
+	}
+	else
+	{
+		jobs::parallel_for(count, min_batch_size, compute_new_bounds, nullptr);
+	}
+
+	// NOTE: the tree is only touched by bounds that left their fat box, and most of those
+	//		 are refitted in place. Only bounds that moved far are reinserted.
+	new_static_ids.clear();
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		const uint32 index{ update_ids[i] };
+		const aabb& box{ new_bounds[i] };
+		uint32& leaf{ leaves[index] };
+
+		if (transform::component{ transform::transform_id{ index } }.is_static())
+		{
+			// NOTE: static bounds only get here when they're created or their local box
+			//		 changed. New ones are added to the static tree below, all at once.
+			world_bounds[index] = box;
+			if (leaf == uint32_invalid_id)
+			{
+				new_static_ids.emplace_back(index);
+				leaf = queued_leaf;
+			}
+			else if (leaf != queued_leaf)
+			{
+				remove_leaf(static_tree, leaf);
+				static_tree.nodes[leaf].box = box;
+				insert_leaf(static_tree, leaf);
+			}
+			continue;
+		}
+
+		if (leaf == uint32_invalid_id)
+		{
+			world_bounds[index] = box;
+			leaf = create_leaf(dynamic_tree, index, compute_fat_bounds(box, {}));
+			continue;
+		}
+
+		const aabb old_box{ world_bounds[index] };
+		world_bounds[index] = box;
+		if (contains(dynamic_tree.nodes[leaf].box, box)) continue;
+
+		const math::Vec3F displacement{ (box.min.x + box.max.x - old_box.min.x - old_box.max.x) * 0.5f,
+										(box.min.y + box.max.y - old_box.min.y - old_box.max.y) * 0.5f,
+										(box.min.z + box.max.z - old_box.min.z - old_box.max.z) * 0.5f };
+		const aabb fat_box{ compute_fat_bounds(box, displacement) };
+		if (refit_leaf(dynamic_tree, leaf, fat_box)) continue;
+
+		remove_leaf(dynamic_tree, leaf);
+		dynamic_tree.nodes[leaf].box = fat_box;
+		insert_leaf(dynamic_tree, leaf);
+	}
+
+	const uint32 num_new_static{ (uint32)new_static_ids.size() };
+	if (!num_new_static) return;
+
+	if (static_tree.root == uint32_invalid_id)
+	{
+		static_tree.root = build_subtree(static_tree, new_static_ids.data(), num_new_static, uint32_invalid_id);
+	}
+	else
+	{
+		for (uint32 i{ 0 }; i < num_new_static; ++i)
+		{
+			const uint32 index{ new_static_ids[i] };
+			leaves[index] = create_leaf(static_tree, index, world_bounds[index]);
+		}
+	}
+}
+
+void save_state(math::Vec3F *const centers, math::Vec3F *const extents, uint32 count)
+{
+	assert((centers && extents) || !count);
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		const bool has_bounds{ exists(i) };
+		centers[i] = has_bounds ? local_centers[i] : math::Vec3F{};
+		extents[i] = has_bounds ? local_extents[i] : math::Vec3F{};
+	}
+}
+
+void restore_state(const math::Vec3F *const centers, const math::Vec3F *const extents,
+				   const game_entity::entity_id *const saved_owners, uint32 count)
+{
+	assert((centers && extents && saved_owners) || !count);
+	clear_tree(dynamic_tree);
+	clear_tree(static_tree);
+
+	local_centers.resize(count);
+	local_extents.resize(count);
+	world_bounds.resize(count);
+	leaves.resize(count);
+	owners.resize(count);
+	if (count)
+	{
+		memcpy(local_centers.data(), centers, count * sizeof(math::Vec3F));
+		memcpy(local_extents.data(), extents, count * sizeof(math::Vec3F));
+	}
+
+	pending_ids.clear();
+	new_static_ids.clear();
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		leaves[i] = uint32_invalid_id;
+		owners[i] = game_entity::entity{ saved_owners[i] };
+		if (owners[i].is_valid()) pending_ids.emplace_back(i);
+	}
+}
+
+game_entity::entity component::entity() const
+{
+	assert(is_valid() && exists(id::index(_id)));
+	return owners[id::index(_id)];
+}
+
+aabb component::world_bounds() const
+{
+	assert(is_valid() && exists(id::index(_id)));
+	return bounds::world_bounds[id::index(_id)];
+}
+
+void component::set_local_bounds(const math::Vec3F& center, const math::Vec3F& extents)
+{
+	assert(is_valid() && exists(id::index(_id)));
+	const id::id_type index{ id::index(_id) };
+	local_centers[index] = center;
+	local_extents[index] = extents;
+	pending_ids.emplace_back(index);
+}
+
+void query_aabbs(const aabb *const boxes, uint32 count, utl::vector<component>& results, utl::vector<uint32>& offsets)
+{
+	run_queries(boxes, count, results, offsets);
+}
+
+void query_spheres(const sphere *const spheres, uint32 count, utl::vector<component>& results, utl::vector<uint32>& offsets)
+{
+	run_queries(spheres, count, results, offsets);
+}
+
+void query_frustums(const frustum *const frustums, uint32 count, utl::vector<component>& results, utl::vector<uint32>& offsets)
+{
+	run_queries(frustums, count, results, offsets);
+}
+
+void raycast(const ray *const rays, uint32 count, ray_hit *const hits)
+{
+	assert((rays && hits) || !count);
+	raycast_context context{ rays, hits };
+	if (count < min_parallel_rays)
+	{
+		cast_rays(0, count, &context);
+	}
+	else
+	{
+		jobs::parallel_for(count, min_ray_batch_size, cast_rays, &context);
+	}
+}
+
+}
@@ -0,0 +1,31 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#pragma once
+#include "ComponentsCommon.h"
+
+namespace zone::bounds {
+
+// Local-space box, relative to the entity's transform.
+struct init_info
+{
+	float center[3]{};
+	float extents[3]{ 0.5f, 0.5f, 0.5f };
+};
+
+component create(init_info info, game_entity::entity entity);
+void remove(component _component);
+
+// Recomputes the world boxes of the bounds whose transform changed this frame and refits
+// the BVH. Must be called after transform::update_world_matrices() and before
+// transform::clear_changes().
+void update();
+
+// Copies the local boxes of the first 'count' bounds, one per entity slot, for world
+// snapshots (see content::save_world()). Slots without bounds get an empty box.
+void save_state(math::Vec3F *const centers, math::Vec3F *const extents, uint32 count);
+// Removes all bounds and gives slot 'i' of the 'count' slots a bounds when owners[i] is valid.
+// Like new bounds, they're added to the BVH in the next update().
+void restore_state(const math::Vec3F *const centers, const math::Vec3F *const extents,
+				   const game_entity::entity_id *const owners, uint32 count);
+}
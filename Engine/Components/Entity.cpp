@@ -3,6 +3,7 @@
 #include "Entity.h"
 #include "Transform.h"
 #include "Script.h"
+#include "Bounds.h"
 
 namespace zone::game_entity {
 
@@ -10,6 +11,7 @@ namespace {
 
 utl::vector<transform::component>		transforms;
 utl::vector<script::component>			scripts;
+utl::vector<bounds::component>			bounds_components;
 utl::vector<id::generation_type>		generations;
 utl::deque<entity_id>					free_ids;
 
@@ -40,6 +42,7 @@ entity create(entity_info info)
 		//transforms.resize(generations.size());
 		transforms.emplace_back();
 		scripts.emplace_back();
+		bounds_components.emplace_back();
 	}
 	 
 	const entity new_entity{ id };
@@ -53,6 +56,14 @@ entity create(entity_info info)
 		return entity{};
 	}
 
+	//Create bounds component
+	if (info.bounds)
+	{
+		assert(!bounds_components[index].is_valid());
+		bounds_components[index] = bounds::create(*info.bounds, new_entity);
+		assert(bounds_components[index].is_valid());
+	}
+
 	//Create script component
 	if (info.script && info.script->script_creator) 
 	{
@@ -75,6 +86,12 @@ void remove(entity_id id)
 		scripts[index] = {};
 	}
 
+	if (bounds_components[index].is_valid())
+	{
+		bounds::remove(bounds_components[index]);
+		bounds_components[index] = {};
+	}
+
 	transform::remove(transforms[index]);
 	transforms[index] = {};
 	free_ids.push_back(id);
@@ -89,6 +106,92 @@ bool is_alive(entity_id id)
 
 }
 
+uint32 slot_count()
+{
+	return (uint32)generations.size();
+}
+
+uint32 free_id_count()
+{
+	return (uint32)free_ids.size();
+}
+
+entity_id slot_id(uint32 index)
+{
+	assert(index < generations.size());
+	return entity_id{ index | ((id::id_type)generations[index] << id::detail::index_bits) };
+}
+
+void save_registry(id::generation_type *const saved_generations, uint8 *const flags, entity_id *const saved_free_ids)
+{
+	assert(saved_generations && flags && (saved_free_ids || free_ids.empty()));
+	const uint32 count{ (uint32)generations.size() };
+	if (count) memcpy(saved_generations, generations.data(), count * sizeof(id::generation_type));
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		flags[i] = (transforms[i].is_valid() ? slot_flags::alive : 0) |
+				   (bounds_components[i].is_valid() ? slot_flags::has_bounds : 0);
+	}
+
+	for (uint32 i{ 0 }; i < free_ids.size(); ++i)
+	{
+		saved_free_ids[i] = free_ids[i];
+	}
+}
+
+void restore_registry(const id::generation_type *const saved_generations, const uint8 *const flags, uint32 count,
+					  const entity_id *const saved_free_ids, uint32 free_count)
+{
+	assert((saved_generations && flags) || !count);
+	assert(saved_free_ids || !free_count);
+
+	// NOTE: scripts are C++ objects, so they're destroyed one by one. Transforms and bounds
+	//		 are plain data and are replaced all at once by their own restore_state().
+	for (uint32 i{ 0 }; i < scripts.size(); ++i)
+	{
+		if (scripts[i].is_valid()) script::remove(scripts[i]);
+	}
+
+	// NOTE: ids of the removed entities can still be around, e.g. in events, waiting tasks or
+	//		 the content loader, and is_alive() must work for them. So, the registry never
+	//		 shrinks. The slots the snapshot doesn't have are freed like removed entities.
+	const uint32 old_count{ (uint32)generations.size() };
+	const uint32 slot_count{ count > old_count ? count : old_count };
+	generations.resize(slot_count);
+	transforms.resize(slot_count);
+	scripts.resize(slot_count);
+	bounds_components.resize(slot_count);
+	if (count) memcpy(generations.data(), saved_generations, count * sizeof(id::generation_type));
+	for (id::id_type i{ 0 }; i < slot_count; ++i)
+	{
+		const uint8 slot{ i < count ? flags[i] : (uint8)0 };
+		transforms[i] = (slot & slot_flags::alive) ? transform::component{ transform::transform_id{ i } } : transform::component{};
+		scripts[i] = {};
+		bounds_components[i] = (slot & slot_flags::has_bounds) ? bounds::component{ bounds::bounds_id{ i } } : bounds::component{};
+	}
+
+	free_ids.clear();
+	for (uint32 i{ 0 }; i < free_count; ++i)
+	{
+		free_ids.push_back(saved_free_ids[i]);
+	}
+
+	// The slot keeps its generation, which goes up when create() reuses it. This makes the
+	// old ids of the slot stale, like the ids of removed entities.
+	for (uint32 i{ count }; i < slot_count; ++i)
+	{
+		free_ids.push_back(slot_id(i));
+	}
+}
+
+void add_script(entity_id id, const script::init_info& info)
+{
+	assert(is_alive(id) && info.script_creator);
+	const id::id_type index{ id::index(id) };
+	assert(!scripts[index].is_valid());
+	scripts[index] = script::create(info, entity{ id });
+}
+
 transform::component entity::transform() const
 {
 	assert(is_alive(_id));
@@ -103,4 +206,11 @@ script::component entity::script() const
 	return scripts[index];
 }
 
+bounds::component entity::bounds() const
+{
+	assert(is_alive(_id));
+	const id::id_type index{ id::index(_id) };
+	return bounds_components[index];
+}
+
 }
@@ -10,6 +10,7 @@ namespace zone {
 
 INIT_INFO(transform);
 INIT_INFO(script);
+INIT_INFO(bounds);
 
 #undef INIT_INFO
 
@@ -18,11 +19,38 @@ struct entity_info
 {
 	transform::init_info* transform{ nullptr };
 	script::init_info* script{ nullptr };
+	bounds::init_info* bounds{ nullptr };
 };
 	
 entity create(entity_info info);
 void remove(entity_id id);
 bool is_alive(entity_id id);
 
+// The functions below are used by world snapshots (see content::save_world()).
+struct slot_flags
+{
+	enum : uint8
+	{
+		alive = 0x01,
+		has_bounds = 0x02,
+	};
+};
+
+// Number of entity slots, including the slots of removed entities.
+uint32 slot_count();
+uint32 free_id_count();
+// Id of slot 'index' with the generation the slot has now.
+entity_id slot_id(uint32 index);
+// Writes the generation and slot_flags of each of the slot_count() slots and the
+// free_id_count() ids that are waiting to be reused.
+void save_registry(id::generation_type *const generations, uint8 *const flags, entity_id *const free_ids);
+// Removes all entities and replaces the registry with 'count' saved slots. The alive slots
+// get their transform and bounds back, but their data has to be restored with
+// transform::restore_state() and bounds::restore_state(). Scripts are added with add_script().
+// Slots past 'count' are kept as free slots, so the ids of the removed entities stay valid.
+void restore_registry(const id::generation_type *const generations, const uint8 *const flags, uint32 count,
+					  const entity_id *const free_ids, uint32 free_count);
+void add_script(entity_id id, const script::init_info& info);
+
 }
 }
\ No newline at end of file
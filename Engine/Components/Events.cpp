@@ -0,0 +1,210 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#include "Events.h"
+#include "Entity.h"
+#include "Script.h"
+#include "..\EngineAPI\ScriptEvents.h"
+#include <algorithm>
+#include <atomic>
+
+namespace zone::script {
+namespace {
+
+struct alignas(16) event_chunk
+{
+	uint8 bytes[16];
+};
+
+// Each event takes one chunk for its header, followed by the chunks of its data.
+struct event_header
+{
+	uint32									event_type;
+	uint32									chunk_count;
+	game_entity::entity_id					target;
+};
+static_assert(sizeof(event_header) <= sizeof(event_chunk));
+
+// NOTE: every thread that sends events gets its own pair of buffers. Only that thread writes
+//		 to them. dispatch_events() swaps the buffers while no scripts are running and reads
+//		 the ones that were written in the last frame. So, sending an event doesn't lock.
+struct thread_events
+{
+	utl::vector<event_chunk>				buffers[2];
+	uint32									write_index{ 0 };
+};
+
+struct pending_event
+{
+	uint32									event_type;
+	uint32									sequence;
+	detail::script_creator					script_type;
+	game_entity::entity_id					target;
+	const void*								data;
+};
+
+struct handler_entry
+{
+	uint64									script_name_hash;
+	uint32									event_type;
+	detail::event_handler					handler;
+};
+
+	std::atomic<uint32>						next_event_type{ 0 };
+	// NOTE: a deque doesn't move its items, so the threads can keep pointers to their buffers.
+	utl::deque<thread_events>				thread_buffers;
+	std::mutex								thread_buffers_mutex;
+	thread_local thread_events*				local_events{ nullptr };
+
+	utl::vector<pending_event>				pending_events;
+	utl::vector<void*>						batch_scripts;
+	utl::vector<const void*>				batch_events;
+
+utl::vector<handler_entry>& handlers()
+{
+	// NOTE:  we put this static variable in a function because of
+	//        the initialization order of static data. This way, we
+	//		  can be certain that the data is initialized before accessing it.
+	static utl::vector<handler_entry> entries;
+	return entries;
+}
+
+detail::event_handler find_handler(uint64 script_name_hash, uint32 event_type)
+{
+	const utl::vector<handler_entry>& entries{ handlers() };
+	for (uint32 i{ 0 }; i < entries.size(); ++i)
+	{
+		if (entries[i].script_name_hash == script_name_hash && entries[i].event_type == event_type)
+		{
+			return entries[i].handler;
+		}
+	}
+
+	return nullptr;
+}
+
+// Returns the script of 'target' if it's still alive and has a script, or null.
+void* get_target_script(game_entity::entity_id target, detail::script_creator& type)
+{
+	if (!game_entity::is_alive(target)) return nullptr;
+	const component script{ game_entity::entity{ target }.script() };
+	return script.is_valid() ? get_script_data(script, type) : nullptr;
+}
+} // anonymous namespace
+
+namespace detail {
+uint32 new_event_type_id()
+{
+	return next_event_type++;
+}
+
+void* add_event(uint32 event_type, uint32 size, game_entity::entity_id target)
+{
+	if (!local_events)
+	{
+		// Only once per thread.
+		std::lock_guard lock{ thread_buffers_mutex };
+		local_events = &thread_buffers.emplace_back();
+	}
+
+	utl::vector<event_chunk>& buffer{ local_events->buffers[local_events->write_index] };
+	const uint64 first{ buffer.size() };
+	const uint32 chunk_count{ (size + (uint32)sizeof(event_chunk) - 1) / (uint32)sizeof(event_chunk) };
+	for (uint32 i{ 0 }; i <= chunk_count; ++i)
+	{
+		buffer.emplace_back();
+	}
+
+	event_header& header{ *(event_header*)&buffer[first] };
+	header.event_type = event_type;
+	header.chunk_count = chunk_count;
+	header.target = target;
+	return &buffer[first + 1];
+}
+
+uint8 register_event_handler(uint64 script_name_hash, uint32 event_type, event_handler handler)
+{
+	assert(!find_handler(script_name_hash, event_type));
+	handlers().emplace_back(handler_entry{ script_name_hash, event_type, handler });
+	return true;
+}
+} // namespace detail
+
+void dispatch_events()
+{
+	// Events sent from now on are delivered in the next frame.
+	for (uint32 i{ 0 }; i < thread_buffers.size(); ++i)
+	{
+		thread_buffers[i].write_index ^= 1;
+	}
+
+	pending_events.clear();
+	for (uint32 i{ 0 }; i < thread_buffers.size(); ++i)
+	{
+		const utl::vector<event_chunk>& buffer{ thread_buffers[i].buffers[thread_buffers[i].write_index ^ 1] };
+		uint64 at{ 0 };
+		while (at < buffer.size())
+		{
+			const event_header& header{ *(const event_header*)&buffer[at] };
+			detail::script_creator type{ nullptr };
+			if (get_target_script(header.target, type))
+			{
+				pending_events.emplace_back(pending_event{ header.event_type, (uint32)pending_events.size(), type, header.target, &buffer[at + 1] });
+			}
+
+			at += 1 + header.chunk_count;
+		}
+	}
+
+	std::sort(pending_events.begin(), pending_events.end(), [](const pending_event& a, const pending_event& b)
+		{
+			if (a.event_type != b.event_type) return a.event_type < b.event_type;
+			if (a.script_type != b.script_type) return a.script_type < b.script_type;
+			return a.sequence < b.sequence;
+		});
+
+	uint32 first{ 0 };
+	const uint32 count{ (uint32)pending_events.size() };
+	while (first < count)
+	{
+		const pending_event& group{ pending_events[first] };
+		uint32 last{ first + 1 };
+		while (last < count && pending_events[last].event_type == group.event_type && pending_events[last].script_type == group.script_type) ++last;
+
+		const detail::event_handler handler{ find_handler(group.script_type->name_hash, group.event_type) };
+		if (handler)
+		{
+			// NOTE: the scripts are looked up again, because the handlers of earlier groups
+			//		 could have created or removed scripts.
+			batch_scripts.clear();
+			batch_events.clear();
+			for (uint32 i{ first }; i < last; ++i)
+			{
+				detail::script_creator type{ nullptr };
+				void *const script{ get_target_script(pending_events[i].target, type) };
+				if (script && type == group.script_type)
+				{
+					batch_scripts.emplace_back(script);
+					batch_events.emplace_back(pending_events[i].data);
+				}
+			}
+
+			if (batch_scripts.size())
+			{
+				// Scripts removed by the handler stay valid until the whole batch is delivered.
+				begin_deferred_changes();
+				handler(batch_scripts.data(), batch_events.data(), (uint32)batch_scripts.size());
+				end_deferred_changes();
+			}
+		}
+
+		first = last;
+	}
+
+	for (uint32 i{ 0 }; i < thread_buffers.size(); ++i)
+	{
+		thread_buffers[i].buffers[thread_buffers[i].write_index ^ 1].clear();
+	}
+}
+
+}
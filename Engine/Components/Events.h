@@ -0,0 +1,12 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#pragma once
+#include "ComponentsCommon.h"
+
+namespace zone::script {
+
+// Delivers the events sent since the last call. Must be called once per frame on the main
+// thread, while no scripts are running.
+void dispatch_events();
+}
@@ -3,17 +3,93 @@
 
 #include "Script.h"
 #include "Entity.h"
+#include "Transform.h"
+#include "..\Core\JobSystem.h"
+#include "..\EngineAPI\ScriptSystems.h"
+#include <algorithm>
+#include <chrono>
 
 namespace zone::script {
 namespace {
-    utl::vector<detail::script_ptr>			entity_scripts;
-	utl::vector<id::id_type>				id_mapping;
+// NOTE: scripts are stored by type. Each type has its own pool where the scripts are kept
+//		 densely packed in fixed-size blocks. Blocks never move, so the pool can grow while
+//		 scripts are running, and update() handles a whole block with one indirect call.
+constexpr uint32 script_block_size{ 64 * 1024 };
+constexpr uint32 min_parallel_batch_size{ 256 };
+
+struct script_pool
+{
+	detail::script_creator					type{ nullptr };
+	utl::vector<uint8*>						blocks;
+	utl::vector<script_id>					ids;
+	utl::vector<game_entity::entity_id>		entities;
+	// Replaces the update() of the scripts when the type has a script system.
+	detail::script_system					system{ nullptr };
+	uint8									system_access{ 0 };
+	uint32									scripts_per_block{ 0 };
+	uint32									count{ 0 };
+	// Scripts [first_new, count) haven't had their begin_play() call yet.
+	uint32									first_new{ 0 };
+	uint32									tick_interval{ 1 };
+	uint32									next_bucket{ 0 };
+	// Profiling of the current frame.
+	uint64									name_hash{ 0 };
+	uint32									update_count{ 0 };
+	float									milliseconds{ 0.f };
+};
+
+struct script_location
+{
+	uint32									pool{ uint32_invalid_id };
+	uint32									index{ uint32_invalid_id };
+};
+
+	utl::vector<script_pool>				script_pools;
+	utl::vector<script_location>			id_mapping;
 
 	utl::vector<id::generation_type>		generations;
 	utl::deque<script_id>					free_ids;
 
+	utl::vector<type_stats>					last_frame_stats;
+	bool									is_profiling{ false };
 
-using script_registry = std::unordered_map<size_t, detail::script_creator>;
+	struct tick_interval_change
+	{
+		script_id							id;
+		uint32								interval;
+	};
+
+	// NOTE: removing a script or changing its tick interval moves another one into its slot
+	//		 and can free the blocks of its pool. That can't happen while the scripts of a pool
+	//		 are running, so these changes are applied when the deferral ends.
+	uint32									defer_count{ 0 };
+	utl::vector<tick_interval_change>		deferred_interval_changes;
+	utl::vector<script_id>					deferred_removals;
+
+	// Scratch buffers for running script systems.
+	utl::vector<game_entity::entity_id>		system_entities;
+	utl::vector<transform::transform_id>	system_transform_ids;
+	utl::vector<transform::transform_id>	system_changed_ids;
+	utl::vector<math::Vec3F>				system_positions;
+	utl::vector<math::Vec3F>				system_old_positions;
+	utl::vector<math::Vec4F>				system_rotations;
+	utl::vector<math::Vec4F>				system_old_rotations;
+
+
+struct script_entry
+{
+	uint64									tag;
+	detail::script_creator					creator;
+};
+
+// NOTE: script types register themselves during static initialization. The first lookup
+//		 freezes the registry: the entries are sorted by tag once and then searched with
+//		 a branchless binary search, so resolving a script doesn't allocate.
+struct script_registry
+{
+	utl::vector<script_entry>				entries;
+	bool									is_frozen{ false };
+};
 
 script_registry& registery()
 {
@@ -35,29 +111,336 @@ utl::vector<std::string>& script_names()
 }
 #endif
 
+struct system_entry
+{
+	uint64									script_name_hash;
+	detail::script_system					system;
+	uint8									access;
+};
+
+utl::vector<system_entry>& script_systems()
+{
+	// NOTE:  we put this static variable in a function because of
+	//        the initialization order of static data. This way, we 
+	//		  can be certain that the data is initialized before accessing it.
+	static utl::vector<system_entry> systems;
+	return systems;
+}
+
+const system_entry* find_system(uint64 script_name_hash)
+{
+	const utl::vector<system_entry>& systems{ script_systems() };
+	for (uint32 i{ 0 }; i < systems.size(); ++i)
+	{
+		if (systems[i].script_name_hash == script_name_hash) return &systems[i];
+	}
+
+	return nullptr;
+}
+
 bool exists(script_id id)
 {
 	assert(id::is_valid(id));
 	const id::id_type index{ id::index(id) };
-	assert(index < generations.size() && id_mapping[index] < entity_scripts.size());
+	assert(index < generations.size());
 	assert(generations[index] == id::generation(id));
-	return (generations[index] == id::generation(id)) && entity_scripts[id_mapping[index]] && entity_scripts[id_mapping[index]]->is_valid();
+	return (generations[index] == id::generation(id)) && id_mapping[index].pool != uint32_invalid_id;
+}
+
+uint32 get_pool(detail::script_creator type, uint32 tick_interval)
+{
+	// NOTE: there are only a handful of script types, a linear search is fine here.
+	const uint32 pool_count{ (uint32)script_pools.size() };
+	for (uint32 i{ 0 }; i < pool_count; ++i)
+	{
+		if (script_pools[i].type == type && script_pools[i].tick_interval == tick_interval) return i;
+	}
+
+	script_pool& pool{ script_pools.emplace_back() };
+	pool.type = type;
+	pool.tick_interval = tick_interval;
+	pool.name_hash = type->name_hash;
+	if (const system_entry *const entry{ find_system(type->name_hash) })
+	{
+		pool.system = entry->system;
+		pool.system_access = entry->access;
+	}
+	return pool_count;
+}
+
+void* get_script(const script_pool& pool, uint32 index)
+{
+	assert(index < pool.blocks.size() * pool.scripts_per_block);
+	return pool.blocks[index / pool.scripts_per_block] + (index % pool.scripts_per_block) * pool.type->size;
+}
+
+void free_blocks(script_pool& pool)
+{
+	for (uint32 i{ 0 }; i < pool.blocks.size(); ++i)
+	{
+		::operator delete(pool.blocks[i], std::align_val_t{ pool.type->alignment });
+	}
+	pool.blocks.clear();
+}
+
+// Moves the script in slot 'from' to the empty slot 'to' of the same pool.
+void move_script(script_pool& pool, uint32 from, uint32 to)
+{
+	pool.type->relocate(get_script(pool, to), get_script(pool, from));
+	const script_id id{ pool.ids[from] };
+	pool.ids[to] = id;
+	pool.entities[to] = pool.entities[from];
+	id_mapping[id::index(id)].index = to;
+}
+
+// Adds an empty slot for script 'id' to a pool and returns its memory. Scripts that already
+// had their begin_play() call are put before the new ones.
+void* add_slot(uint32 pool_index, script_id id, game_entity::entity_id entity, bool has_begun_play)
+{
+	script_pool& pool{ script_pools[pool_index] };
+	if (!pool.blocks.size())
+	{
+		// NOTE: the block layout is set up again every time a pool starts over, because
+		//		 the game code can be reloaded with a different size for the same type.
+		const uint32 per_block{ script_block_size / pool.type->size };
+		pool.scripts_per_block = per_block ? per_block : 1;
+	}
+
+	if (pool.count == pool.blocks.size() * pool.scripts_per_block)
+	{
+		const size_t block_size{ (size_t)pool.scripts_per_block * pool.type->size };
+		pool.blocks.emplace_back((uint8*)::operator new(block_size, std::align_val_t{ pool.type->alignment }));
+	}
+
+	uint32 index{ pool.count++ };
+	pool.ids.emplace_back(id);
+	pool.entities.emplace_back(entity);
+	if (has_begun_play)
+	{
+		if (pool.first_new != index)
+		{
+			move_script(pool, pool.first_new, index);
+			index = pool.first_new;
+		}
+		++pool.first_new;
+	}
+
+	pool.ids[index] = id;
+	pool.entities[index] = entity;
+	id_mapping[id::index(id)] = { pool_index, index };
+	return get_script(pool, index);
+}
+
+// Closes the hole at 'index' that was left by a destroyed or moved script.
+void remove_slot(script_pool& pool, uint32 index)
+{
+	// NOTE: the new scripts are kept at the end of the pool. A hole before them is filled
+	//		 with the last script that had begin_play(), which moves the hole to the start
+	//		 of the new scripts.
+	if (index < pool.first_new)
+	{
+		const uint32 last_played{ pool.first_new - 1 };
+		if (index != last_played) move_script(pool, last_played, index);
+		index = last_played;
+		--pool.first_new;
+	}
+
+	const uint32 last{ pool.count - 1 };
+	if (index != last) move_script(pool, last, index);
+	pool.ids.erase(last);
+	pool.entities.erase(last);
+	--pool.count;
+	if (!pool.count) free_blocks(pool);
+}
+
+// Calls 'func(pool, scripts, first, count)' for each run of contiguous scripts in [begin, end).
+// NOTE: scripts can create other scripts while they run, which may grow script_pools.
+//		 So, the pool is looked up again for every run.
+template<typename F>
+void for_each_run(uint32 pool_index, uint32 begin, uint32 end, F func)
+{
+	while (begin < end)
+	{
+		const script_pool& pool{ script_pools[pool_index] };
+		const uint32 offset{ begin % pool.scripts_per_block };
+		const uint32 left_in_block{ pool.scripts_per_block - offset };
+		const uint32 count{ end - begin < left_in_block ? end - begin : left_in_block };
+		func(pool, get_script(pool, begin), begin, count);
+		begin += count;
+	}
+}
+
+struct update_context
+{
+	uint32									pool;
+	uint32									first;
+	float									dt;
+};
+
+// Updates the scripts [first + begin, first + end) of a pool. Used as a job function by parallel_for().
+void update_range(uint32 begin, uint32 end, void* context)
+{
+	const update_context& ctx{ *(const update_context*)context };
+	const float dt{ ctx.dt };
+	for_each_run(ctx.pool, ctx.first + begin, ctx.first + end,
+		[dt](const script_pool& pool, void* scripts, uint32, uint32 count) { pool.type->update_all(scripts, count, dt); });
+}
+
+template<typename T>
+void reserve_scratch(utl::vector<T>& buffer, uint32 count)
+{
+	if (buffer.size() < count) buffer.resize(count);
+}
+
+// Writes the values that the system changed back to the transforms.
+template<typename T, typename F>
+void write_back(utl::vector<T>& values, const utl::vector<T>& old_values, uint32 count, F set_values)
+{
+	uint32 changed{ 0 };
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		if (memcmp(&values[i], &old_values[i], sizeof(T)))
+		{
+			system_changed_ids[changed] = system_transform_ids[i];
+			values[changed] = values[i];
+			++changed;
+		}
+	}
+
+	if (changed) set_values({ system_changed_ids.data(), changed }, { values.data(), changed });
+}
+
+// Runs the script system of a pool on its scripts [begin, end).
+void run_system(uint32 pool_index, uint32 begin, uint32 end, float dt)
+{
+	for_each_run(pool_index, begin, end, [dt](const script_pool& pool, void* scripts, uint32 first, uint32 count)
+		{
+			reserve_scratch(system_entities, count);
+			reserve_scratch(system_transform_ids, count);
+			reserve_scratch(system_changed_ids, count);
+			reserve_scratch(system_positions, count);
+			reserve_scratch(system_old_positions, count);
+			reserve_scratch(system_rotations, count);
+			reserve_scratch(system_old_rotations, count);
+
+			// NOTE: the system can create scripts, which may move the pool's arrays.
+			//		 So, it gets copies of the entity ids.
+			memcpy(system_entities.data(), &pool.entities[first], count * sizeof(game_entity::entity_id));
+			for (uint32 i{ 0 }; i < count; ++i)
+			{
+				system_transform_ids[i] = transform::transform_id{ id::index(system_entities[i]) };
+			}
+
+			const uint8 access{ pool.system_access };
+			math::Vec3F* positions{ nullptr };
+			math::Vec4F* rotations{ nullptr };
+			if (access & system_access::positions)
+			{
+				positions = system_positions.data();
+				transform::get_positions({ system_transform_ids.data(), count }, { positions, count });
+				memcpy(system_old_positions.data(), positions, count * sizeof(math::Vec3F));
+			}
+
+			if (access & system_access::rotations)
+			{
+				rotations = system_rotations.data();
+				transform::get_rotations({ system_transform_ids.data(), count }, { rotations, count });
+				memcpy(system_old_rotations.data(), rotations, count * sizeof(math::Vec4F));
+			}
+
+			pool.system(scripts, system_entities.data(), positions, rotations, count, dt);
+
+			if (positions) write_back(system_positions, system_old_positions, count, transform::set_positions);
+			if (rotations) write_back(system_rotations, system_old_rotations, count, transform::set_rotations);
+		});
+}
+
+void remove_script(script_id id)
+{
+	const script_location location{ id_mapping[id::index(id)] };
+	script_pool& pool{ script_pools[location.pool] };
+	assert(pool.count && location.index < pool.count);
+	pool.type->destroy(get_script(pool, location.index));
+	remove_slot(pool, location.index);
+
+	id_mapping[id::index(id)] = {};
+	free_ids.push_back(id);
+}
+
+void change_tick_interval(script_id id, uint32 interval)
+{
+	const script_location location{ id_mapping[id::index(id)] };
+	if (script_pools[location.pool].tick_interval == interval) return;
+
+	const uint32 pool_index{ get_pool(script_pools[location.pool].type, interval) };
+	// NOTE: get_pool() may grow script_pools, so take the reference afterwards.
+	script_pool& from{ script_pools[location.pool] };
+	const bool has_begun_play{ location.index < from.first_new };
+	from.type->relocate(add_slot(pool_index, id, from.entities[location.index], has_begun_play), get_script(from, location.index));
+	remove_slot(from, location.index);
+}
+
+void begin_play_new_scripts()
+{
+	for (uint32 i{ 0 }; i < script_pools.size(); ++i)
+	{
+		// NOTE: scripts created by begin_play() get their own call in the next round.
+		while (script_pools[i].first_new < script_pools[i].count)
+		{
+			const uint32 begin{ script_pools[i].first_new };
+			const uint32 end{ script_pools[i].count };
+			script_pools[i].first_new = end;
+			for_each_run(i, begin, end,
+				[](const script_pool& pool, void* scripts, uint32, uint32 count) { pool.type->begin_play_all(scripts, count); });
+		}
+	}
 }
 } // anonymous namespace
 
 namespace detail {
-uint8 register_script(size_t tag, script_creator func) 
+uint8 register_script_system(uint64 script_name_hash, script_system system, uint8 access)
+{
+	assert(!find_system(script_name_hash));
+	script_systems().emplace_back(system_entry{ script_name_hash, system, access });
+	return true;
+}
+
+uint8 register_script(uint64 tag, script_creator func) 
 {
-	bool result{ registery().insert(script_registry::value_type{tag, func}).second };
-	assert(result);
-	return result;
+	script_registry& reg{ registery() };
+	assert(!reg.is_frozen);
+	reg.entries.emplace_back(script_entry{ tag, func });
+	return true;
 }
 
-script_creator get_script_creator(size_t tag)
+script_creator get_script_creator(uint64 tag)
 {
-	const auto script{ registery().find(tag) };
-	assert(script != registery().end() && script->first == tag);
-	return script->second;
+	script_registry& reg{ registery() };
+	if (!reg.is_frozen)
+	{
+		std::sort(reg.entries.begin(), reg.entries.end(),
+			[](const script_entry& a, const script_entry& b) { return a.tag < b.tag; });
+		for (uint32 i{ 1 }; i < reg.entries.size(); ++i)
+		{
+			// Two script types with the same name (or a hash collision).
+			assert(reg.entries[i - 1].tag != reg.entries[i].tag);
+		}
+		reg.is_frozen = true;
+	}
+
+	uint64 length{ reg.entries.size() };
+	if (!length) return nullptr;
+
+	const script_entry* first{ reg.entries.data() };
+	while (length > 1)
+	{
+		const uint64 half{ length / 2 };
+		first = first[half].tag <= tag ? first + half : first;
+		length -= half;
+	}
+
+	assert(first->tag == tag);
+	return first->tag == tag ? first->creator : nullptr;
 }
 
 #ifdef USE_WITH_EDITOR
@@ -92,30 +475,167 @@ component create(init_info info, game_entity::entity entity)
 	}
 
 	assert(id::is_valid(id));
-	const id::id_type index{ (id::id_type)entity_scripts.size() };
-	entity_scripts.emplace_back(info.script_creator(entity));
-	assert(entity_scripts.back()->get_id() == entity.get_id());
-	id_mapping[id::index(id)] = index;
+	const uint32 pool_index{ get_pool(info.script_creator, info.script_creator->tick_interval) };
+	script_pools[pool_index].type->construct(add_slot(pool_index, id, entity.get_id(), false), entity);
 	return component{ id };
 }
 
 void remove(component _component)
 {
 	assert(_component.is_valid() && exists(_component.get_id()));
-	const script_id id{ _component.get_id() };
-	const id::id_type index{ id_mapping[id::index(id)] };
-	const script_id last_id{ entity_scripts.back()->script().get_id() };
-	utl::erase_unordered(entity_scripts, index);
-	id_mapping[id::index(last_id)] = index;
-	id_mapping[id::index(id)] = id::invalid_id;
+	if (defer_count)
+	{
+		deferred_removals.emplace_back(_component.get_id());
+		return;
+	}
+
+	remove_script(_component.get_id());
+}
+
+void begin_deferred_changes()
+{
+	++defer_count;
 }
 
-void update(float deltaTime) 
+void end_deferred_changes()
 {
-	for (auto& ptr : entity_scripts)
+	assert(defer_count);
+	if (--defer_count) return;
+
+	// Interval changes first, because a script can change its interval and then be removed.
+	for (uint32 i{ 0 }; i < deferred_interval_changes.size(); ++i)
+	{
+		change_tick_interval(deferred_interval_changes[i].id, deferred_interval_changes[i].interval);
+	}
+	deferred_interval_changes.clear();
+
+	for (uint32 i{ 0 }; i < deferred_removals.size(); ++i)
 	{
-		ptr->update(deltaTime);
+		remove_script(deferred_removals[i]);
 	}
+	deferred_removals.clear();
+}
+
+void update(float deltaTime, tick_group::group group) 
+{
+	begin_deferred_changes();
+	begin_play_new_scripts();
+
+	for (uint32 i{ 0 }; i < script_pools.size(); ++i)
+	{
+		// NOTE: check the count first. Empty pools can belong to unloaded game code.
+		script_pool& pool{ script_pools[i] };
+		if (!pool.count || pool.type->group != group) continue;
+
+		update_context context{ i, 0, deltaTime };
+		uint32 count{ pool.count };
+		if (pool.tick_interval > 1)
+		{
+			// NOTE: a pool that ticks every N steps is split in N buckets that are updated
+			//		 one after the other, so the scripts are spread over the steps.
+			const uint64 bucket{ pool.next_bucket };
+			context.first = (uint32)(count * bucket / pool.tick_interval);
+			count = (uint32)(count * (bucket + 1) / pool.tick_interval) - context.first;
+			context.dt = deltaTime * pool.tick_interval;
+			pool.next_bucket = (pool.next_bucket + 1) % pool.tick_interval;
+		}
+
+		const bool parallel_safe{ pool.type->parallel_safe };
+		std::chrono::steady_clock::time_point start{};
+		if (is_profiling) start = std::chrono::steady_clock::now();
+
+		if (pool.system)
+		{
+			// NOTE: the system runs on the calling thread, it gets its scripts in large batches.
+			run_system(i, context.first, context.first + count, context.dt);
+		}
+		else if (parallel_safe)
+		{
+			// Parallel-safe scripts don't create other scripts, so the pool stays put.
+			jobs::parallel_for(count, min_parallel_batch_size, update_range, &context);
+		}
+		else
+		{
+			update_range(0, count, &context);
+		}
+
+		if (is_profiling)
+		{
+			const std::chrono::duration<float, std::milli> time{ std::chrono::steady_clock::now() - start };
+			script_pools[i].update_count += count;
+			script_pools[i].milliseconds += time.count();
+		}
+	}
+
+	end_deferred_changes();
+}
+
+void* get_script_data(component _component, detail::script_creator& type)
+{
+	assert(_component.is_valid() && exists(_component.get_id()));
+	const script_location location{ id_mapping[id::index(_component.get_id())] };
+	const script_pool& pool{ script_pools[location.pool] };
+	type = pool.type;
+	return get_script(pool, location.index);
+}
+
+detail::script_creator get_script_type(component _component, uint32& tick_interval)
+{
+	assert(_component.is_valid() && exists(_component.get_id()));
+	const script_location location{ id_mapping[id::index(_component.get_id())] };
+	const script_pool& pool{ script_pools[location.pool] };
+	tick_interval = pool.tick_interval;
+	return pool.type;
+}
+
+void enable_profiling(bool enable)
+{
+	is_profiling = enable;
+}
+
+bool is_profiling_enabled()
+{
+	return is_profiling;
+}
+
+void end_frame()
+{
+	last_frame_stats.clear();
+	for (uint32 i{ 0 }; i < script_pools.size(); ++i)
+	{
+		script_pool& pool{ script_pools[i] };
+		if (!pool.update_count) continue;
+
+		// NOTE: the pools of one type with different tick intervals share one entry.
+		uint32 index{ 0 };
+		while (index < last_frame_stats.size() && last_frame_stats[index].name_hash != pool.name_hash) ++index;
+		if (index == last_frame_stats.size())
+		{
+			last_frame_stats.emplace_back(type_stats{ pool.name_hash, 0, 0.f });
+		}
+
+		last_frame_stats[index].update_count += pool.update_count;
+		last_frame_stats[index].milliseconds += pool.milliseconds;
+		pool.update_count = 0;
+		pool.milliseconds = 0.f;
+	}
+}
+
+const utl::vector<type_stats>& frame_stats()
+{
+	return last_frame_stats;
+}
+
+void component::set_tick_interval(uint32 interval) const
+{
+	assert(is_valid() && exists(_id) && interval);
+	if (defer_count)
+	{
+		deferred_interval_changes.emplace_back(tick_interval_change{ _id, interval });
+		return;
+	}
+
+	change_tick_interval(_id, interval);
 }
 
 }
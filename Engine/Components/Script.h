@@ -11,6 +11,42 @@ namespace zone::script {
 	};
 
 	component create(init_info info, game_entity::entity entity);
+	// Removes a script. While changes are deferred, the script is only destroyed by the
+	// matching end_deferred_changes() and it may still get calls until then. The rest of
+	// its entity is removed right away, so it shouldn't use its entity in those calls.
 	void remove(component _component);
-	void update(float deltaTime);
+	// Calls begin_play() of the scripts created since the last call, then updates the
+	// scripts in 'group'. Removals and tick interval changes made by the scripts are applied
+	// at the end.
+	void update(float deltaTime, tick_group::group group);
+	// Defers removals and tick interval changes until the matching end_deferred_changes(), so
+	// that scripts can be called in batches while they make these changes. Calls can be nested.
+	void begin_deferred_changes();
+	void end_deferred_changes();
+
+	// Returns the script of '_component' and its type. The pointer is only valid until the
+	// next script is removed.
+	void* get_script_data(component _component, detail::script_creator& type);
+	// Returns the type of the script of '_component' and the number of steps between its
+	// updates, e.g. to save it in a world snapshot.
+	detail::script_creator get_script_type(component _component, uint32& tick_interval);
+
+	// Update cost of one script type over one frame.
+	struct type_stats
+	{
+		// hash_script_name() of the name given to REGISTER_SCRIPT.
+		uint64 name_hash;
+		// Number of update() calls.
+		uint32 update_count;
+		float milliseconds;
+	};
+
+	// NOTE: profiling takes one pair of timestamps for every batch of scripts of the same
+	//		 type, not for every script. It's off by default.
+	void enable_profiling(bool enable);
+	bool is_profiling_enabled();
+	// Makes the stats gathered since the last call available through frame_stats().
+	void end_frame();
+	// Stats of the last frame, one entry per script type that was updated.
+	const utl::vector<type_stats>& frame_stats();
 }
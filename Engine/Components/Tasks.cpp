@@ -0,0 +1,272 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#include "Tasks.h"
+#include "Entity.h"
+#include "Script.h"
+#include "..\EngineAPI\ScriptTasks.h"
+#include <algorithm>
+
+namespace zone::script {
+namespace {
+
+// NOTE: coroutine frames are taken from per-size free lists that are filled from larger
+//		 slabs. Frames bigger than the largest size class use the global heap.
+constexpr uint32 frame_size_step{ 64 };
+constexpr uint32 frame_size_classes{ 16 };
+constexpr uint32 frame_slab_size{ 64 * 1024 };
+
+struct free_frame
+{
+	free_frame*								next;
+};
+
+struct waiting_task
+{
+	std::coroutine_handle<>					handle;
+	game_entity::entity_id					owner;
+};
+
+struct task_timer
+{
+	double									wake_time;
+	uint64									sequence;
+	waiting_task							task;
+};
+
+struct trigger_state
+{
+	utl::vector<waiting_task>				waiters;
+	bool									is_fired{ false };
+};
+
+	free_frame*								free_frames[frame_size_classes]{};
+	utl::vector<uint8*>						frame_slabs;
+
+	// Min-heap on wake time. The sequence keeps timers that run out together in order.
+	utl::vector<task_timer>					timers;
+	uint64									timer_sequence{ 0 };
+	double									task_time{ 0.0 };
+
+	utl::vector<trigger_state>				triggers;
+	utl::vector<uint32>						free_triggers;
+
+	// Tasks that are ready to be resumed in the next update_tasks().
+	utl::vector<waiting_task>				ready_tasks;
+	utl::vector<waiting_task>				resumed_tasks;
+
+	// NOTE: tasks can start and wait on worker threads, e.g. from parallel-safe scripts.
+	std::mutex								task_mutex;
+
+bool timer_after(const task_timer& a, const task_timer& b)
+{
+	return a.wake_time != b.wake_time ? a.wake_time > b.wake_time : a.sequence > b.sequence;
+}
+
+bool is_owner_alive(game_entity::entity_id owner)
+{
+	return !id::is_valid(owner) || game_entity::is_alive(owner);
+}
+} // anonymous namespace
+
+namespace detail {
+void* allocate_task_frame(uint64 size)
+{
+	const uint32 size_class{ (uint32)((size + frame_size_step - 1) / frame_size_step) - 1 };
+	if (size_class >= frame_size_classes) return ::operator new(size);
+
+	std::lock_guard lock{ task_mutex };
+	if (!free_frames[size_class])
+	{
+		const uint32 frame_size{ (size_class + 1) * frame_size_step };
+		uint8 *const slab{ (uint8*)::operator new(frame_slab_size) };
+		frame_slabs.emplace_back(slab);
+		for (uint32 offset{ 0 }; offset + frame_size <= frame_slab_size; offset += frame_size)
+		{
+			free_frame *const frame{ (free_frame*)(slab + offset) };
+			frame->next = free_frames[size_class];
+			free_frames[size_class] = frame;
+		}
+	}
+
+	free_frame *const frame{ free_frames[size_class] };
+	free_frames[size_class] = frame->next;
+	return frame;
+}
+
+void free_task_frame(void* frame, uint64 size)
+{
+	const uint32 size_class{ (uint32)((size + frame_size_step - 1) / frame_size_step) - 1 };
+	if (size_class >= frame_size_classes)
+	{
+		::operator delete(frame);
+		return;
+	}
+
+	std::lock_guard lock{ task_mutex };
+	free_frame *const item{ (free_frame*)frame };
+	item->next = free_frames[size_class];
+	free_frames[size_class] = item;
+}
+
+void add_task_timer(std::coroutine_handle<> handle, game_entity::entity_id owner, float seconds)
+{
+	std::lock_guard lock{ task_mutex };
+	timers.emplace_back(task_timer{ task_time + seconds, timer_sequence++, { handle, owner } });
+	std::push_heap(timers.begin(), timers.end(), timer_after);
+}
+
+void* get_entity_script(game_entity::entity_id id)
+{
+	if (!game_entity::is_alive(id)) return nullptr;
+	const component script{ game_entity::entity{ id }.script() };
+	detail::script_creator type{ nullptr };
+	return script.is_valid() ? get_script_data(script, type) : nullptr;
+}
+
+uint32 create_trigger()
+{
+	std::lock_guard lock{ task_mutex };
+	if (free_triggers.size())
+	{
+		const uint32 id{ free_triggers[free_triggers.size() - 1] };
+		free_triggers.erase(free_triggers.size() - 1);
+		triggers[id].is_fired = false;
+		return id;
+	}
+
+	triggers.emplace_back();
+	return (uint32)triggers.size() - 1;
+}
+
+void remove_trigger(uint32 id)
+{
+	utl::vector<waiting_task> waiters;
+	{
+		std::lock_guard lock{ task_mutex };
+		assert(id < triggers.size());
+		waiters.swap(triggers[id].waiters);
+		free_triggers.emplace_back(id);
+	}
+
+	// NOTE: nobody can fire this trigger anymore, so its tasks would wait forever. They're
+	//		 destroyed outside the lock, because their frames can hold other triggers.
+	for (uint32 i{ 0 }; i < waiters.size(); ++i)
+	{
+		waiters[i].handle.destroy();
+	}
+}
+
+void fire_trigger(uint32 id)
+{
+	std::lock_guard lock{ task_mutex };
+	assert(id < triggers.size());
+	trigger_state& trigger{ triggers[id] };
+	trigger.is_fired = true;
+	for (uint32 i{ 0 }; i < trigger.waiters.size(); ++i)
+	{
+		ready_tasks.emplace_back(trigger.waiters[i]);
+	}
+	trigger.waiters.clear();
+}
+
+void reset_trigger(uint32 id)
+{
+	std::lock_guard lock{ task_mutex };
+	assert(id < triggers.size());
+	triggers[id].is_fired = false;
+}
+
+bool is_trigger_fired(uint32 id)
+{
+	std::lock_guard lock{ task_mutex };
+	assert(id < triggers.size());
+	return triggers[id].is_fired;
+}
+
+void add_trigger_waiter(uint32 id, std::coroutine_handle<> handle, game_entity::entity_id owner)
+{
+	std::lock_guard lock{ task_mutex };
+	assert(id < triggers.size());
+	if (triggers[id].is_fired)
+	{
+		// Fired between await_ready() and now.
+		ready_tasks.emplace_back(waiting_task{ handle, owner });
+		return;
+	}
+
+	triggers[id].waiters.emplace_back(waiting_task{ handle, owner });
+}
+} // namespace detail
+
+void remove_entity_tasks()
+{
+	utl::vector<std::coroutine_handle<>> removed_tasks;
+	auto remove_owned = [&removed_tasks](utl::vector<waiting_task>& tasks)
+		{
+			uint32 kept{ 0 };
+			for (uint32 i{ 0 }; i < tasks.size(); ++i)
+			{
+				if (id::is_valid(tasks[i].owner)) removed_tasks.emplace_back(tasks[i].handle);
+				else tasks[kept++] = tasks[i];
+			}
+			tasks.resize(kept);
+		};
+
+	{
+		std::lock_guard lock{ task_mutex };
+		remove_owned(ready_tasks);
+		for (uint32 i{ 0 }; i < triggers.size(); ++i)
+		{
+			remove_owned(triggers[i].waiters);
+		}
+
+		uint32 kept{ 0 };
+		for (uint32 i{ 0 }; i < timers.size(); ++i)
+		{
+			if (id::is_valid(timers[i].task.owner)) removed_tasks.emplace_back(timers[i].task.handle);
+			else timers[kept++] = timers[i];
+		}
+		timers.resize(kept);
+		if (kept) std::make_heap(timers.begin(), timers.end(), timer_after);
+	}
+
+	// NOTE: destroying a frame can remove the triggers it holds, which takes the lock.
+	for (uint32 i{ 0 }; i < removed_tasks.size(); ++i)
+	{
+		removed_tasks[i].destroy();
+	}
+}
+
+void update_tasks(float dt)
+{
+	{
+		std::lock_guard lock{ task_mutex };
+		task_time += dt;
+		resumed_tasks.clear();
+		resumed_tasks.swap(ready_tasks);
+		while (timers.size() && timers[0].wake_time <= task_time)
+		{
+			std::pop_heap(timers.begin(), timers.end(), timer_after);
+			resumed_tasks.emplace_back(timers[timers.size() - 1].task);
+			timers.erase(timers.size() - 1);
+		}
+	}
+
+	// NOTE: the resumed tasks can wait again, which adds them back to the timers or the
+	//		 ready list, not to resumed_tasks.
+	for (uint32 i{ 0 }; i < resumed_tasks.size(); ++i)
+	{
+		const waiting_task& task{ resumed_tasks[i] };
+		if (is_owner_alive(task.owner))
+		{
+			task.handle.resume();
+		}
+		else
+		{
+			task.handle.destroy();
+		}
+	}
+}
+
+}
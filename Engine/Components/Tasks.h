@@ -0,0 +1,15 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#pragma once
+#include "ComponentsCommon.h"
+
+namespace zone::script {
+
+// Advances the task clock by 'dt' and resumes the tasks whose wait is over: timers that ran
+// out and triggers that fired. Tasks of removed entities are destroyed instead.
+void update_tasks(float dt);
+// Destroys the waiting tasks that belong to an entity, e.g. before all entities are replaced
+// by a world snapshot. Tasks without an owner keep waiting.
+void remove_entity_tasks();
+}
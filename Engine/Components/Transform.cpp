@@ -3,13 +3,439 @@
 
 #include "Transform.h"
 #include "Entity.h"
+#include "..\Core\JobSystem.h"
+#include "..\Utilities\MathSIMD.h"
+#include <xmmintrin.h>
+#include <atomic>
+#include <mutex>
 
 namespace zone::transform {
 
 namespace {
 utl::vector<math::Vec3F> positions;
-utl::vector<math::Vec4F> rotations;
+utl::vector<rotation_storage> rotations;
 utl::vector<math::Vec3F> scales;
+utl::vector<math::Mat3x4F> world_matrices;
+
+// NOTE: dirty_flags holds the changed_flags of each transform for the current frame.
+//		 changed_ids is the compacted list of transforms with non-zero flags, so that
+//		 per-frame systems only visit the transforms that actually changed.
+utl::vector<uint8> dirty_flags;
+utl::vector<transform_id> changed_ids;
+
+// NOTE: static transforms never change after creation. Their world matrix is computed in
+//		 the first update after they're created and they never enter the per-frame change
+//		 and moving lists again, so a frame only costs as much as the dynamic transforms
+//		 that actually moved.
+utl::vector<uint8> static_flags;
+
+// NOTE: the state at the end of the previous simulation step is kept for transforms that
+//		 moved in the last step (moving_ids), so that the world matrices can be built from
+//		 a pose interpolated between the previous and current steps. For all other
+//		 transforms the previous state is the same as the current state.
+utl::vector<math::Vec3F> prev_positions;
+utl::vector<rotation_storage> prev_rotations;
+utl::vector<math::Vec3F> prev_scales;
+utl::vector<uint8> moving_flags;
+utl::vector<uint32> moving_ids;
+utl::vector<uint32> settled_ids;
+float interpolation_alpha{ 1.f };
+bool is_interpolation_enabled{ false };
+
+// NOTE: transform snapshots are triple-buffered. The simulation thread fills write_index,
+//		 the reader thread uses read_index and the third buffer holds the latest published
+//		 state. ready_state packs the index of that buffer with a flag telling whether it
+//		 was published after the reader last acquired a snapshot. Publishing and acquiring
+//		 are a single atomic exchange each, so neither side ever waits for the other.
+struct snapshot_buffer
+{
+	utl::vector<math::Vec3F>	positions;
+	utl::vector<rotation_storage>	rotations;
+	utl::vector<math::Vec3F>	scales;
+	utl::vector<math::Mat3x4F>	world_matrices;
+	uint64						frame{ 0 };
+};
+
+constexpr uint32 snapshot_index_mask{ 0x03 };
+constexpr uint32 snapshot_new_flag{ 0x04 };
+// Number of frames of change lists we keep around to bring a stale buffer up to date.
+constexpr uint32 change_history_frames{ 4 };
+
+snapshot_buffer snapshot_buffers[3];
+std::atomic<uint32> ready_state{ 1 };
+uint32 write_index{ 0 };
+uint32 read_index{ 2 };
+uint64 published_frame{ 0 };
+utl::vector<uint32> change_history[change_history_frames];
+
+// NOTE: below this number of transforms the cost of waking up the workers is higher
+//		 than the cost of computing the matrices on the calling thread.
+constexpr uint32 min_parallel_count{ 16 * 1024 };
+constexpr uint32 min_batch_size{ 4 * 1024 };
+
+#if USE_COMPRESSED_ROTATIONS
+uint32 pack_rotation(const math::Vec4F& rotation) { return math::packQuaternion32(rotation); }
+math::Vec4F unpack_rotation(uint32 rotation) { return math::unpackQuaternion32(rotation); }
+// Batched rotations are packed and unpacked this many at a time, in a buffer on the stack.
+constexpr uint32 rotation_batch_size{ 256 };
+#else
+const math::Vec4F& pack_rotation(const math::Vec4F& rotation) { return rotation; }
+const math::Vec4F& unpack_rotation(const math::Vec4F& rotation) { return rotation; }
+#endif
+
+// Writes the affine world matrix (T * R * S) of transform 'index' in 3x4 form: each row
+// holds the scaled rotation row followed by the translation component.
+void compute_world_matrix(uint32 index)
+{
+	const math::Vec3F& p{ positions[index] };
+	const math::Vec4F q{ unpack_rotation(rotations[index]) };
+	const math::Vec3F& s{ scales[index] };
+
+	const float xx{ q.x * q.x }, yy{ q.y * q.y }, zz{ q.z * q.z };
+	const float xy{ q.x * q.y }, xz{ q.x * q.z }, yz{ q.y * q.z };
+	const float wx{ q.w * q.x }, wy{ q.w * q.y }, wz{ q.w * q.z };
+
+	math::Mat3x4F& m{ world_matrices[index] };
+	m._11 = s.x * (1.f - 2.f * (yy + zz));
+	m._12 = s.y * 2.f * (xy - wz);
+	m._13 = s.z * 2.f * (xz + wy);
+	m._14 = p.x;
+
+	m._21 = s.x * 2.f * (xy + wz);
+	m._22 = s.y * (1.f - 2.f * (xx + zz));
+	m._23 = s.z * 2.f * (yz - wx);
+	m._24 = p.y;
+
+	m._31 = s.x * 2.f * (xz - wy);
+	m._32 = s.y * 2.f * (yz + wx);
+	m._33 = s.z * (1.f - 2.f * (xx + yy));
+	m._34 = p.z;
+}
+
+// Loads 4 consecutive Vec3F values and transposes them into x, y and z lanes.
+void load_vec3_lanes(const math::Vec3F* v, __m128& x, __m128& y, __m128& z)
+{
+	const float* const f{ &v->x };
+	const __m128 a{ _mm_loadu_ps(f) };		// x0 y0 z0 x1
+	const __m128 b{ _mm_loadu_ps(f + 4) };	// y1 z1 x2 y2
+	const __m128 c{ _mm_loadu_ps(f + 8) };	// z2 x3 y3 z3
+
+	const __m128 bc_x{ _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)) };
+	x = _mm_shuffle_ps(a, bc_x, _MM_SHUFFLE(2, 0, 3, 0));
+
+	const __m128 ab_y{ _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)) };
+	const __m128 bc_y{ _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)) };
+	y = _mm_shuffle_ps(ab_y, bc_y, _MM_SHUFFLE(2, 0, 2, 0));
+
+	const __m128 ab_z{ _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)) };
+	const __m128 cc_z{ _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)) };
+	z = _mm_shuffle_ps(ab_z, cc_z, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// Transform data of 4 transforms in SoA form, one transform per lane.
+struct transform_lanes
+{
+	__m128 px, py, pz;
+	__m128 qx, qy, qz, qw;
+	__m128 sx, sy, sz;
+};
+
+void load_lanes(uint32 index, transform_lanes& l)
+{
+	load_vec3_lanes(&positions[index], l.px, l.py, l.pz);
+	load_vec3_lanes(&scales[index], l.sx, l.sy, l.sz);
+
+#if USE_COMPRESSED_ROTATIONS
+	math::unpackQuaternion32Lanes(_mm_loadu_si128((const __m128i*)&rotations[index]), l.qx, l.qy, l.qz, l.qw);
+#else
+	l.qx = _mm_loadu_ps(&rotations[index + 0].x);
+	l.qy = _mm_loadu_ps(&rotations[index + 1].x);
+	l.qz = _mm_loadu_ps(&rotations[index + 2].x);
+	l.qw = _mm_loadu_ps(&rotations[index + 3].x);
+	_MM_TRANSPOSE4_PS(l.qx, l.qy, l.qz, l.qw);
+#endif
+}
+
+void gather_lanes(const utl::vector<math::Vec3F>& pos, const utl::vector<rotation_storage>& rot,
+				  const utl::vector<math::Vec3F>& scl, const uint32 (&indices)[4], transform_lanes& l)
+{
+	const math::Vec3F& p0{ pos[indices[0]] }; const math::Vec3F& s0{ scl[indices[0]] };
+	const math::Vec3F& p1{ pos[indices[1]] }; const math::Vec3F& s1{ scl[indices[1]] };
+	const math::Vec3F& p2{ pos[indices[2]] }; const math::Vec3F& s2{ scl[indices[2]] };
+	const math::Vec3F& p3{ pos[indices[3]] }; const math::Vec3F& s3{ scl[indices[3]] };
+
+	l.px = _mm_setr_ps(p0.x, p1.x, p2.x, p3.x);
+	l.py = _mm_setr_ps(p0.y, p1.y, p2.y, p3.y);
+	l.pz = _mm_setr_ps(p0.z, p1.z, p2.z, p3.z);
+	l.sx = _mm_setr_ps(s0.x, s1.x, s2.x, s3.x);
+	l.sy = _mm_setr_ps(s0.y, s1.y, s2.y, s3.y);
+	l.sz = _mm_setr_ps(s0.z, s1.z, s2.z, s3.z);
+
+#if USE_COMPRESSED_ROTATIONS
+	const __m128i packed{ _mm_setr_epi32((int)rot[indices[0]], (int)rot[indices[1]], (int)rot[indices[2]], (int)rot[indices[3]]) };
+	math::unpackQuaternion32Lanes(packed, l.qx, l.qy, l.qz, l.qw);
+#else
+	l.qx = _mm_loadu_ps(&rot[indices[0]].x);
+	l.qy = _mm_loadu_ps(&rot[indices[1]].x);
+	l.qz = _mm_loadu_ps(&rot[indices[2]].x);
+	l.qw = _mm_loadu_ps(&rot[indices[3]].x);
+	_MM_TRANSPOSE4_PS(l.qx, l.qy, l.qz, l.qw);
+#endif
+}
+
+// Replaces 'from' with the pose at 't' between 'from' and 'to'. Positions and scales are
+// linearly interpolated and rotations use a normalized lerp along the shortest path.
+void interpolate_lanes(transform_lanes& from, const transform_lanes& to, __m128 t)
+{
+	const __m128 one{ _mm_set1_ps(1.f) };
+	const __m128 s{ _mm_sub_ps(one, t) };
+	auto lerp = [&](__m128 a, __m128 b) { return _mm_add_ps(_mm_mul_ps(a, s), _mm_mul_ps(b, t)); };
+
+	from.px = lerp(from.px, to.px);
+	from.py = lerp(from.py, to.py);
+	from.pz = lerp(from.pz, to.pz);
+	from.sx = lerp(from.sx, to.sx);
+	from.sy = lerp(from.sy, to.sy);
+	from.sz = lerp(from.sz, to.sz);
+
+	// NOTE: q and -q are the same rotation, flip 'to' when it's in the other hemisphere.
+	const __m128 dot{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(from.qx, to.qx), _mm_mul_ps(from.qy, to.qy)),
+								 _mm_add_ps(_mm_mul_ps(from.qz, to.qz), _mm_mul_ps(from.qw, to.qw))) };
+	const __m128 flip{ _mm_and_ps(dot, _mm_set1_ps(-0.f)) };
+	const __m128 qx{ lerp(from.qx, _mm_xor_ps(to.qx, flip)) };
+	const __m128 qy{ lerp(from.qy, _mm_xor_ps(to.qy, flip)) };
+	const __m128 qz{ lerp(from.qz, _mm_xor_ps(to.qz, flip)) };
+	const __m128 qw{ lerp(from.qw, _mm_xor_ps(to.qw, flip)) };
+	const __m128 length_sq{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)),
+									   _mm_add_ps(_mm_mul_ps(qz, qz), _mm_mul_ps(qw, qw))) };
+	const __m128 inv_length{ _mm_div_ps(one, _mm_sqrt_ps(length_sq)) };
+	from.qx = _mm_mul_ps(qx, inv_length);
+	from.qy = _mm_mul_ps(qy, inv_length);
+	from.qz = _mm_mul_ps(qz, inv_length);
+	from.qw = _mm_mul_ps(qw, inv_length);
+}
+
+// Takes the next 4 indices from [begin, end). When fewer than 4 are left, the last index
+// is repeated, which just writes the same matrix more than once.
+void next_indices(const uint32 *const indices, uint32 i, uint32 end, uint32 (&idx)[4])
+{
+	for (uint32 j{ 0 }; j < 4; ++j)
+	{
+		idx[j] = indices[i + j < end ? i + j : end - 1];
+	}
+}
+
+// Computes the world matrices of 4 transforms and stores them in 'out'.
+// The rows are computed for all lanes at once and transposed back before being stored.
+void compute_world_matrices_x4(const transform_lanes& l, math::Mat3x4F *const (&out)[4])
+{
+	const __m128 one{ _mm_set1_ps(1.f) };
+	const __m128 two{ _mm_set1_ps(2.f) };
+	const __m128 xx{ _mm_mul_ps(l.qx, l.qx) }, yy{ _mm_mul_ps(l.qy, l.qy) }, zz{ _mm_mul_ps(l.qz, l.qz) };
+	const __m128 xy{ _mm_mul_ps(l.qx, l.qy) }, xz{ _mm_mul_ps(l.qx, l.qz) }, yz{ _mm_mul_ps(l.qy, l.qz) };
+	const __m128 wx{ _mm_mul_ps(l.qw, l.qx) }, wy{ _mm_mul_ps(l.qw, l.qy) }, wz{ _mm_mul_ps(l.qw, l.qz) };
+
+	__m128 r0[4]
+	{
+		_mm_mul_ps(l.sx, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz)))),
+		_mm_mul_ps(l.sy, _mm_mul_ps(two, _mm_sub_ps(xy, wz))),
+		_mm_mul_ps(l.sz, _mm_mul_ps(two, _mm_add_ps(xz, wy))),
+		l.px,
+	};
+	__m128 r1[4]
+	{
+		_mm_mul_ps(l.sx, _mm_mul_ps(two, _mm_add_ps(xy, wz))),
+		_mm_mul_ps(l.sy, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz)))),
+		_mm_mul_ps(l.sz, _mm_mul_ps(two, _mm_sub_ps(yz, wx))),
+		l.py,
+	};
+	__m128 r2[4]
+	{
+		_mm_mul_ps(l.sx, _mm_mul_ps(two, _mm_sub_ps(xz, wy))),
+		_mm_mul_ps(l.sy, _mm_mul_ps(two, _mm_add_ps(yz, wx))),
+		_mm_mul_ps(l.sz, _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy)))),
+		l.pz,
+	};
+
+	_MM_TRANSPOSE4_PS(r0[0], r0[1], r0[2], r0[3]);
+	_MM_TRANSPOSE4_PS(r1[0], r1[1], r1[2], r1[3]);
+	_MM_TRANSPOSE4_PS(r2[0], r2[1], r2[2], r2[3]);
+
+	for (uint32 i{ 0 }; i < 4; ++i)
+	{
+		_mm_storeu_ps(&out[i]->_11, r0[i]);
+		_mm_storeu_ps(&out[i]->_21, r1[i]);
+		_mm_storeu_ps(&out[i]->_31, r2[i]);
+	}
+}
+
+void compute_world_matrices(uint32 begin, uint32 end, void*)
+{
+	uint32 i{ begin };
+	for (; i + 4 <= end; i += 4)
+	{
+		transform_lanes lanes;
+		load_lanes(i, lanes);
+		math::Mat3x4F *const out[4]{ &world_matrices[i], &world_matrices[i + 1], &world_matrices[i + 2], &world_matrices[i + 3] };
+		compute_world_matrices_x4(lanes, out);
+	}
+
+	for (; i < end; ++i)
+	{
+		compute_world_matrix(i);
+	}
+}
+
+// Same as compute_world_matrices() but for the transforms in the index list passed as 'context'.
+void compute_indexed_world_matrices(uint32 begin, uint32 end, void* context)
+{
+	const uint32 *const indices{ (const uint32*)context };
+	for (uint32 i{ begin }; i < end; i += 4)
+	{
+		uint32 idx[4];
+		next_indices(indices, i, end, idx);
+		transform_lanes lanes;
+		gather_lanes(positions, rotations, scales, idx, lanes);
+		math::Mat3x4F *const out[4]{ &world_matrices[idx[0]], &world_matrices[idx[1]], &world_matrices[idx[2]], &world_matrices[idx[3]] };
+		compute_world_matrices_x4(lanes, out);
+	}
+}
+
+// Computes the world matrices of moving transforms from their interpolated pose.
+void compute_interpolated_world_matrices(uint32 begin, uint32 end, void*)
+{
+	const uint32 *const indices{ moving_ids.data() };
+	const __m128 t{ _mm_set1_ps(interpolation_alpha) };
+	for (uint32 i{ begin }; i < end; i += 4)
+	{
+		uint32 idx[4];
+		next_indices(indices, i, end, idx);
+		transform_lanes from, to;
+		gather_lanes(prev_positions, prev_rotations, prev_scales, idx, from);
+		gather_lanes(positions, rotations, scales, idx, to);
+		interpolate_lanes(from, to, t);
+		math::Mat3x4F *const out[4]{ &world_matrices[idx[0]], &world_matrices[idx[1]], &world_matrices[idx[2]], &world_matrices[idx[3]] };
+		compute_world_matrices_x4(from, out);
+	}
+}
+
+void run_batches(jobs::job_func func, uint32 count, void* context)
+{
+	if (count < min_parallel_count)
+	{
+		func(0, count, context);
+	}
+	else
+	{
+		jobs::parallel_for(count, min_batch_size, func, context);
+	}
+}
+
+// NOTE: parallel-safe scripts move their entities from the worker threads. The flags of one
+//		 transform are only touched by one thread, but the id lists are shared and appending
+//		 to them is guarded by this mutex. Batched writes lock it once per batch.
+std::mutex change_mutex;
+
+void mark_changed(id::id_type index, uint8 flags)
+{
+	assert(index < dirty_flags.size());
+	if (!dirty_flags[index])
+	{
+		std::lock_guard lock{ change_mutex };
+		changed_ids.emplace_back(transform_id{ index });
+	}
+	dirty_flags[index] |= flags;
+}
+
+void mark_dirty(id::id_type index, uint8 flags)
+{
+	assert(!static_flags[index]);
+	mark_changed(index, flags);
+	if (is_interpolation_enabled && !moving_flags[index])
+	{
+		moving_flags[index] = 1;
+		std::lock_guard lock{ change_mutex };
+		moving_ids.emplace_back(index);
+	}
+}
+
+// Same as mark_changed(), for batches that hold change_mutex for the whole batch.
+void mark_changed_locked(id::id_type index, uint8 flags)
+{
+	assert(index < dirty_flags.size());
+	if (!dirty_flags[index])
+	{
+		changed_ids.emplace_back(transform_id{ index });
+	}
+	dirty_flags[index] |= flags;
+}
+
+// Marks all moving transforms as changed with 'flags', under a single lock.
+void mark_moving_changed(uint8 flags)
+{
+	std::lock_guard lock{ change_mutex };
+	if (changed_ids.capacity() < changed_ids.size() + moving_ids.size())
+	{
+		changed_ids.reserve(changed_ids.size() + moving_ids.size());
+	}
+
+	for (uint32 i{ 0 }; i < moving_ids.size(); ++i)
+	{
+		mark_changed_locked(moving_ids[i], flags);
+	}
+}
+
+// Same as mark_dirty(), for batched writes that hold change_mutex for the whole batch.
+void mark_dirty_locked(id::id_type index, uint8 flags)
+{
+	assert(!static_flags[index]);
+	mark_changed_locked(index, flags);
+	if (is_interpolation_enabled && !moving_flags[index])
+	{
+		moving_flags[index] = 1;
+		moving_ids.emplace_back(index);
+	}
+}
+
+template<typename T>
+void resize_buffer(utl::vector<T>& buffer, uint64 size)
+{
+	if (buffer.size() < size)
+	{
+		buffer.resize(size);
+	}
+}
+
+template<typename T>
+void copy_changed(utl::vector<T>& dst, const utl::vector<T>& src, const utl::vector<uint32>& indices)
+{
+	for (uint32 i{ 0 }; i < indices.size(); ++i)
+	{
+		dst[indices[i]] = src[indices[i]];
+	}
+}
+
+template<typename T>
+void write_values(utl::vector<T>& dst, std::span<const transform_id> ids, std::span<const T> values, uint8 flags)
+{
+	assert(ids.size() == values.size());
+	const uint32 count{ (uint32)ids.size() };
+	std::lock_guard lock{ change_mutex };
+	if (changed_ids.capacity() < changed_ids.size() + count)
+	{
+		changed_ids.reserve(changed_ids.size() + count);
+	}
+
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		assert(id::is_valid(ids[i]));
+		const id::id_type index{ id::index(ids[i]) };
+		assert(index < dst.size());
+		dst[index] = values[i];
+		mark_dirty_locked(index, flags);
+	}
+}
+
 } // anonymous namespace
 
 component create(init_info info, game_entity::entity entity)
@@ -20,18 +446,37 @@ component create(init_info info, game_entity::entity entity)
 	if (positions.size() > entity_index)
 	{
 		positions[entity_index] = math::Vec3F(info.position);
-		rotations[entity_index] = math::Vec4F(info.rotation);
+		rotations[entity_index] = pack_rotation(math::Vec4F(info.rotation));
 		scales[entity_index] = math::Vec3F(info.scale);
+		prev_positions[entity_index] = positions[entity_index];
+		prev_rotations[entity_index] = rotations[entity_index];
+		prev_scales[entity_index] = scales[entity_index];
+		static_flags[entity_index] = info.is_static;
 	}
 	else
 	{
 		assert(positions.size() == entity_index);
-		rotations.emplace_back(info.rotation);
+		rotations.emplace_back(pack_rotation(math::Vec4F(info.rotation)));
 		positions.emplace_back(info.position);
 		scales.emplace_back(info.scale);
+		prev_positions.emplace_back(positions.back());
+		prev_rotations.emplace_back(rotations.back());
+		prev_scales.emplace_back(scales.back());
+		world_matrices.emplace_back();
+		dirty_flags.emplace_back(0);
+		moving_flags.emplace_back(0);
+		static_flags.emplace_back(info.is_static);
 	}
 
-	return component(transform_id{ (id::id_type)positions.size() - 1 });
+	if (info.is_static)
+	{
+		mark_changed(entity_index, changed_flags::all);
+	}
+	else
+	{
+		mark_dirty(entity_index, changed_flags::all);
+	}
+	return component(transform_id{ entity_index });
 }
 
 void remove(component _component)
@@ -39,6 +484,288 @@ void remove(component _component)
 	assert(_component.is_valid());
 }
 
+void begin_simulation_step()
+{
+	if (!is_interpolation_enabled)
+	{
+		// NOTE: transforms written before the first step don't have a valid previous state yet.
+		const uint64 count{ positions.size() };
+		if (count)
+		{
+			memcpy(prev_positions.data(), positions.data(), count * sizeof(math::Vec3F));
+			memcpy(prev_rotations.data(), rotations.data(), count * sizeof(rotation_storage));
+			memcpy(prev_scales.data(), scales.data(), count * sizeof(math::Vec3F));
+		}
+		is_interpolation_enabled = true;
+	}
+
+	for (uint32 i{ 0 }; i < moving_ids.size(); ++i)
+	{
+		const uint32 index{ moving_ids[i] };
+		prev_positions[index] = positions[index];
+		prev_rotations[index] = rotations[index];
+		prev_scales[index] = scales[index];
+		moving_flags[index] = 0;
+	}
+
+	// NOTE: the last world matrix may be an interpolated one. If a transform doesn't move
+	//		 in the new step it will still get its final matrix in the next update.
+	mark_moving_changed(changed_flags::interpolated);
+	moving_ids.clear();
+}
+
+void update_world_matrices(float alpha)
+{
+	assert(alpha >= 0.f && alpha <= 1.f);
+
+	// NOTE: the pose of moving transforms changes every frame (alpha changes) even when
+	//		 no simulation step ran, so they're always part of this frame's changes.
+	mark_moving_changed(changed_flags::interpolated);
+
+	const uint32 count{ (uint32)positions.size() };
+	const uint32 num_changed{ (uint32)changed_ids.size() };
+
+	// NOTE: when most transforms changed, going through the arrays in order
+	//		 is cheaper than gathering the changed ones.
+	if (num_changed * 4 > count)
+	{
+		run_batches(compute_world_matrices, count, nullptr);
+	}
+	else
+	{
+		settled_ids.clear();
+		for (uint32 i{ 0 }; i < num_changed; ++i)
+		{
+			const id::id_type index{ id::index(changed_ids[i]) };
+			if (!moving_flags[index]) settled_ids.emplace_back(index);
+		}
+		run_batches(compute_indexed_world_matrices, (uint32)settled_ids.size(), settled_ids.data());
+	}
+
+	interpolation_alpha = alpha;
+	run_batches(compute_interpolated_world_matrices, (uint32)moving_ids.size(), nullptr);
+}
+
+const math::Mat3x4F *const get_world_matrices()
+{
+	return world_matrices.empty() ? nullptr : world_matrices.data();
+}
+
+uint32 count()
+{
+	return (uint32)world_matrices.size();
+}
+
+const transform_id *const get_changed_ids()
+{
+	return changed_ids.empty() ? nullptr : changed_ids.data();
+}
+
+uint32 changed_count()
+{
+	return (uint32)changed_ids.size();
+}
+
+uint8 get_changed_flags(transform_id id)
+{
+	assert(id::is_valid(id) && id::index(id) < dirty_flags.size());
+	return dirty_flags[id::index(id)];
+}
+
+void set_positions(std::span<const transform_id> ids, std::span<const math::Vec3F> values)
+{
+	write_values(positions, ids, values, changed_flags::position);
+}
+
+void set_rotations(std::span<const transform_id> ids, std::span<const math::Vec4F> values)
+{
+#if USE_COMPRESSED_ROTATIONS
+	assert(ids.size() == values.size());
+	for (uint64 first{ 0 }; first < ids.size(); first += rotation_batch_size)
+	{
+		const uint32 count{ (uint32)std::min<uint64>(ids.size() - first, rotation_batch_size) };
+		uint32 packed[rotation_batch_size];
+		math::packQuaternions32(&values[first], &packed[0], count);
+		write_values(rotations, ids.subspan(first, count), std::span<const uint32>{ &packed[0], count }, changed_flags::rotation);
+	}
+#else
+	write_values(rotations, ids, values, changed_flags::rotation);
+#endif
+}
+
+void set_scales(std::span<const transform_id> ids, std::span<const math::Vec3F> values)
+{
+	write_values(scales, ids, values, changed_flags::scale);
+}
+
+void get_positions(std::span<const transform_id> ids, std::span<math::Vec3F> values)
+{
+	assert(ids.size() == values.size());
+	for (uint32 i{ 0 }; i < ids.size(); ++i)
+	{
+		assert(id::is_valid(ids[i]) && id::index(ids[i]) < positions.size());
+		values[i] = positions[id::index(ids[i])];
+	}
+}
+
+void get_rotations(std::span<const transform_id> ids, std::span<math::Vec4F> values)
+{
+	assert(ids.size() == values.size());
+#if USE_COMPRESSED_ROTATIONS
+	for (uint64 first{ 0 }; first < ids.size(); first += rotation_batch_size)
+	{
+		const uint32 count{ (uint32)std::min<uint64>(ids.size() - first, rotation_batch_size) };
+		uint32 packed[rotation_batch_size];
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			const transform_id id{ ids[first + i] };
+			assert(id::is_valid(id) && id::index(id) < rotations.size());
+			packed[i] = rotations[id::index(id)];
+		}
+		math::unpackQuaternions32(&packed[0], &values[first], count);
+	}
+#else
+	for (uint32 i{ 0 }; i < ids.size(); ++i)
+	{
+		assert(id::is_valid(ids[i]) && id::index(ids[i]) < rotations.size());
+		values[i] = rotations[id::index(ids[i])];
+	}
+#endif
+}
+
+void publish_snapshot()
+{
+	++published_frame;
+	utl::vector<uint32>& history{ change_history[published_frame % change_history_frames] };
+	history.clear();
+	for (uint32 i{ 0 }; i < changed_ids.size(); ++i)
+	{
+		history.emplace_back(id::index(changed_ids[i]));
+	}
+
+	snapshot_buffer& buffer{ snapshot_buffers[write_index] };
+	const uint64 count{ positions.size() };
+	resize_buffer(buffer.positions, count);
+	resize_buffer(buffer.rotations, count);
+	resize_buffer(buffer.scales, count);
+	resize_buffer(buffer.world_matrices, count);
+
+	if (!buffer.frame || published_frame - buffer.frame > change_history_frames)
+	{
+		// NOTE: this buffer was never written or missed more frames than we have
+		//		 change lists for, so copy everything.
+		if (count)
+		{
+			memcpy(buffer.positions.data(), positions.data(), count * sizeof(math::Vec3F));
+			memcpy(buffer.rotations.data(), rotations.data(), count * sizeof(rotation_storage));
+			memcpy(buffer.scales.data(), scales.data(), count * sizeof(math::Vec3F));
+			memcpy(buffer.world_matrices.data(), world_matrices.data(), count * sizeof(math::Mat3x4F));
+		}
+	}
+	else
+	{
+		// Copy only the transforms that changed since this buffer was last published.
+		for (uint64 frame{ buffer.frame + 1 }; frame <= published_frame; ++frame)
+		{
+			const utl::vector<uint32>& indices{ change_history[frame % change_history_frames] };
+			copy_changed(buffer.positions, positions, indices);
+			copy_changed(buffer.rotations, rotations, indices);
+			copy_changed(buffer.scales, scales, indices);
+			copy_changed(buffer.world_matrices, world_matrices, indices);
+		}
+	}
+
+	buffer.frame = published_frame;
+	const uint32 previous{ ready_state.exchange(write_index | snapshot_new_flag, std::memory_order_acq_rel) };
+	write_index = previous & snapshot_index_mask;
+}
+
+snapshot acquire_snapshot()
+{
+	if (ready_state.load(std::memory_order_acquire) & snapshot_new_flag)
+	{
+		const uint32 previous{ ready_state.exchange(read_index, std::memory_order_acq_rel) };
+		read_index = previous & snapshot_index_mask;
+	}
+
+	const snapshot_buffer& buffer{ snapshot_buffers[read_index] };
+	snapshot result{};
+	if (buffer.frame)
+	{
+		result.positions = buffer.positions.data();
+		result.rotations = buffer.rotations.data();
+		result.scales = buffer.scales.data();
+		result.world_matrices = buffer.world_matrices.data();
+		result.count = (uint32)buffer.positions.size();
+		result.frame = buffer.frame;
+	}
+	return result;
+}
+
+void save_state(math::Vec3F *const saved_positions, rotation_storage *const saved_rotations, math::Vec3F *const saved_scales,
+				uint8 *const saved_static_flags, uint32 count)
+{
+	assert(count <= positions.size());
+	if (!count) return;
+	memcpy(saved_positions, positions.data(), count * sizeof(math::Vec3F));
+	memcpy(saved_rotations, rotations.data(), count * sizeof(rotation_storage));
+	memcpy(saved_scales, scales.data(), count * sizeof(math::Vec3F));
+	memcpy(saved_static_flags, static_flags.data(), count * sizeof(uint8));
+}
+
+void restore_state(const math::Vec3F *const saved_positions, const rotation_storage *const saved_rotations,
+				   const math::Vec3F *const saved_scales, const uint8 *const saved_static_flags, uint32 count)
+{
+	// NOTE: the arrays only grow. Slots past 'count' don't belong to an entity anymore and
+	//		 are reused when entities are created in them again.
+	if (positions.size() < count)
+	{
+		positions.resize(count);
+		rotations.resize(count);
+		scales.resize(count);
+		prev_positions.resize(count);
+		prev_rotations.resize(count);
+		prev_scales.resize(count);
+		world_matrices.resize(count);
+		dirty_flags.resize(count, 0);
+		moving_flags.resize(count, 0);
+		static_flags.resize(count, 0);
+	}
+
+	if (count)
+	{
+		memcpy(positions.data(), saved_positions, count * sizeof(math::Vec3F));
+		memcpy(rotations.data(), saved_rotations, count * sizeof(rotation_storage));
+		memcpy(scales.data(), saved_scales, count * sizeof(math::Vec3F));
+		memcpy(static_flags.data(), saved_static_flags, count * sizeof(uint8));
+	}
+
+	// Nothing is moving anymore. The previous state is copied again in the next step.
+	for (uint32 i{ 0 }; i < moving_ids.size(); ++i)
+	{
+		moving_flags[moving_ids[i]] = 0;
+	}
+	moving_ids.clear();
+	is_interpolation_enabled = false;
+
+	clear_changes();
+	changed_ids.reserve(count);
+	for (id::id_type i{ 0 }; i < count; ++i)
+	{
+		dirty_flags[i] = changed_flags::all;
+		changed_ids.emplace_back(transform_id{ i });
+	}
+}
+
+void clear_changes()
+{
+	for (uint32 i{ 0 }; i < changed_ids.size(); ++i)
+	{
+		dirty_flags[id::index(changed_ids[i])] = 0;
+	}
+	changed_ids.clear();
+}
+
 math::Vec3F component::position() const 
 {
 	assert(is_valid());
@@ -47,12 +774,44 @@ math::Vec3F component::position() const
 math::Vec4F component::rotation() const 
 {
 	assert(is_valid());
-	return rotations[id::index(_id)];
+	return unpack_rotation(rotations[id::index(_id)]);
 }
 math::Vec3F component::scale() const 
 {
 	assert(is_valid());
 	return scales[id::index(_id)];
 }
+bool component::is_static() const
+{
+	assert(is_valid());
+	return static_flags[id::index(_id)];
+}
+math::Mat3x4F component::world_matrix() const
+{
+	assert(is_valid());
+	return world_matrices[id::index(_id)];
+}
 
+void component::set_position(const math::Vec3F& position)
+{
+	assert(is_valid());
+	const id::id_type index{ id::index(_id) };
+	positions[index] = position;
+	mark_dirty(index, changed_flags::position);
 }
+void component::set_rotation(const math::Vec4F& rotation)
+{
+	assert(is_valid());
+	const id::id_type index{ id::index(_id) };
+	rotations[index] = pack_rotation(rotation);
+	mark_dirty(index, changed_flags::rotation);
+}
+void component::set_scale(const math::Vec3F& scale)
+{
+	assert(is_valid());
+	const id::id_type index{ id::index(_id) };
+	scales[index] = scale;
+	mark_dirty(index, changed_flags::scale);
+}
+
+}
\ No newline at end of file
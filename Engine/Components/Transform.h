@@ -4,15 +4,96 @@
 #pragma once
 #include "ComponentsCommon.h"
 
+// When set to 1, rotations are stored as 32-bit smallest-three quaternions (see
+// math::packQuaternion32()) instead of 4 floats. This cuts rotation memory and bandwidth
+// by 4 at the cost of ~0.25 degrees of precision.
+#define USE_COMPRESSED_ROTATIONS 0
+
 namespace zone::transform {
 
+#if USE_COMPRESSED_ROTATIONS
+using rotation_storage = uint32;
+#else
+using rotation_storage = math::Vec4F;
+#endif
+
 struct init_info 
 {
 	float position[3]{};
 	float rotation[4]{};
 	float scale[3]{ 1.f,1.f,1.f };
+	// Static transforms can't be moved after creation.
+	// NOTE: static and dynamic transforms share the same arrays, indexed by entity id. Per-frame
+	//		 work only visits the transforms that moved, so static ones cost nothing per frame,
+	//		 but they don't have a range of their own. load_game() creates the dynamic entities
+	//		 first so that their data is close together, but entities created later, by the
+	//		 editor or by restoring a world snapshot reuse free ids and mix both kinds again.
+	bool is_static{ false };
+};
+
+struct changed_flags
+{
+	enum : uint8
+	{
+		position = 0x01,
+		rotation = 0x02,
+		scale = 0x04,
+		// Only the world matrix changed, because the interpolated pose moved.
+		interpolated = 0x08,
+
+		all = position | rotation | scale
+	};
+};
+
+// Read-only view of the transform state as it was at the end of a simulation frame.
+struct snapshot
+{
+	const math::Vec3F*		positions{ nullptr };
+	const rotation_storage*	rotations{ nullptr };
+	const math::Vec3F*		scales{ nullptr };
+	const math::Mat3x4F*	world_matrices{ nullptr };
+	uint32					count{ 0 };
+	uint64					frame{ 0 };
 };
 
 component create(init_info info, game_entity::entity entity);
 void remove(component _component);
-}
\ No newline at end of file
+
+// Recomputes the 3x4 world matrices of the transforms that changed this frame. This is
+// the only place where world matrices are produced; bounds::update() reads them
+// through get_world_matrices(). Transforms that moved in the last simulation step use
+// their pose interpolated by 'alpha' between the previous and the current step.
+void update_world_matrices(float alpha = 1.f);
+// Called before each fixed simulation step. Saves the current state of the transforms that
+// moved in the previous step as their previous state. The first call enables interpolation.
+void begin_simulation_step();
+// Returns the world matrices indexed by transform id. Might be null.
+const math::Mat3x4F *const get_world_matrices();
+uint32 count();
+
+// Ids of the transforms that changed since the last call to clear_changes(). Each id
+// appears once. Might be null.
+const transform_id *const get_changed_ids();
+uint32 changed_count();
+// Returns a combination of changed_flags describing what changed this frame.
+uint8 get_changed_flags(transform_id id);
+// Called once per frame after all consumers processed the change list.
+void clear_changes();
+
+// Copies the transforms that changed into the snapshot buffer owned by the simulation and
+// makes it the latest snapshot. Must be called once per frame, after update_world_matrices()
+// and before clear_changes().
+void publish_snapshot();
+// Returns the latest published snapshot without locking. The data stays valid and unchanged
+// until the next call to acquire_snapshot(). Only a single reader thread is supported.
+snapshot acquire_snapshot();
+
+// Copies the first 'count' transforms, one per entity slot, for world snapshots
+// (see content::save_world()).
+void save_state(math::Vec3F *const positions, rotation_storage *const rotations, math::Vec3F *const scales,
+				uint8 *const static_flags, uint32 count);
+// Replaces the first 'count' transforms with saved ones. They all count as changed, so their
+// world matrices are computed again in the next update_world_matrices().
+void restore_state(const math::Vec3F *const positions, const rotation_storage *const rotations,
+				   const math::Vec3F *const scales, const uint8 *const static_flags, uint32 count);
+}
@@ -5,10 +5,16 @@
 #include "..\Components\Entity.h"
 #include "..\Components\Transform.h"
 #include "..\Components\Script.h"
+#include "..\Components\Bounds.h"
+#include "..\Platform\MappedFile.h"
+#include "Package.h"
+#include "..\Core\JobSystem.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
 
 #if !defined(SHIPPING)  
 
-#include <fstream>
 #include <filesystem>
 #include <Windows.h>
 namespace zone::content {
@@ -23,49 +29,241 @@ enum component_type
 
     count
 };
+// NOTE: the entity type field in game.bin holds these flags.
+enum entity_flags : uint32
+{
+    is_static = 0x01,
+};
+
 utl::vector<game_entity::entity> entities;
-transform::init_info transform_info{};
-script::init_info script_info{};
+// NOTE: game.bin doesn't store bounds yet, loaded entities get a unit box.
+bounds::init_info bounds_info{};
+// The pages of game.bin that were parsed are released in steps of this size.
+constexpr uint64 release_step{ 16 * 1024 * 1024 };
+// NOTE: the editor packs the game files into this package next to the executable. Files
+//       that aren't in it are read from disk as they are, e.g. while testing a level.
+constexpr const char* game_package_name{ "game.pak" };
+package game_package{};
+
+// A game file, either mapped from disk or read from the game package.
+struct game_file
+{
+    platform::MappedFile                    mapping;
+    utl::vector<uint8>                      buffer;
+    const uint8*                            data{ nullptr };
+    uint64                                  size{ 0 };
+};
+
+// NOTE: game.bin v2 layout. Offsets are from the start of the file, every section starts
+//       on a 16-byte boundary and the records in it are 4- or 16-byte aligned:
+//          game_bin_header             magic, version and counts
+//          game_bin_section[]          where each section is
+//          entities section            one entity_record per entity, in editor order
+//          transforms section          one transform_record per transform, as one block
+//          scripts section             one script_record per script type used in the game
+//       Version 2 files have a names section with the UTF-8 names of the script types and
+//       their script records point into it. From version 3 on, the script records hold the
+//       hash_script_name() of the names instead, so loading doesn't hash any strings.
+//       Files without the magic are v1 streams and are read by decode_game_v1().
+constexpr uint32 game_bin_magic{ 'Z' | ('G' << 8) | ('B' << 16) | ('2' << 24) };
+constexpr uint32 game_bin_min_version{ 2 };
+constexpr uint32 game_bin_version{ 3 };
+
+struct section_type
+{
+    enum type : uint32
+    {
+        entities,
+        transforms,
+        scripts,
+        names,
+
+        count
+    };
+};
+
+struct game_bin_header
+{
+    uint32 magic;
+    uint32 version;
+    uint32 entity_count;
+    uint32 section_count;
+};
+
+struct game_bin_section
+{
+    uint32 type;
+    uint32 count;
+    uint32 offset;
+    uint32 size;
+};
+
+// 'components' has bit (1 << component_type) set for each component of the entity. The
+// indices point into the records of the component sections.
+struct entity_record
+{
+    uint32 flags;
+    uint32 components;
+    uint32 transform_index;
+    // NOTE: version 2 files store a 32-bit script index here. Their script tables never
+    //       have more than 64K entries, so the upper half is always 0.
+    uint16 script_index;
+    uint16 reserved;
+};
+
+struct transform_record
+{
+    float position[3];
+    math::PackedQuaternion48 rotation;
+    uint16 padding;
+    float scale[3];
+};
 
-bool read_transform(const uint8*& data, game_entity::entity_info& info) 
+union script_record
 {
+    struct
+    {
+        uint32 name_offset;
+        uint32 name_length;
+    } name;                                 // version 2
+    uint64 name_hash;                       // version 3
+};
+
+static_assert(sizeof(game_bin_header) == 16 && sizeof(game_bin_section) == 16);
+static_assert(sizeof(entity_record) == 16 && sizeof(transform_record) == 32);
+static_assert(sizeof(script_record) == 8);
+
+// Where a script name of a v1 file is stored in decoded_game::script_name_chars.
+struct script_name
+{
+    uint32                                  offset;
+    uint32                                  length;
+};
+
+// A game file decoded into init_infos, ready to create its entities. Decoding doesn't touch
+// engine state, so it can run on any thread. The script types are resolved afterwards on the
+// main thread, because the script registry isn't thread-safe.
+struct decoded_game
+{
+    utl::vector<game_entity::entity_info>   entity_infos;
+    utl::vector<transform::init_info>       transform_infos;
+    // Index into 'script_hashes' for each entity, or uint32_invalid_id if it has no script.
+    utl::vector<uint32>                     script_indices;
+    utl::vector<uint64>                     script_hashes;
+    // v1 files only: the names of 'script_hashes', so that every name is hashed once.
+    utl::vector<script_name>                script_names;
+    utl::vector<char>                       script_name_chars;
+    utl::vector<script::init_info>          script_infos;
+    // Indices of the entities in the order they're created.
+    utl::vector<uint32>                     creation_order;
+};
+
+struct decode_context
+{
+    const entity_record*                    entity_records;
+    const transform_record*                 transform_records;
+    uint32                                  transform_count;
+    uint32                                  script_count;
+    decoded_game*                           game;
+    std::atomic<bool>                       is_valid{ true };
+};
+
+// Entities decoded per job. Each job writes only the infos of its own entities.
+constexpr uint32 min_decode_batch_size{ 1024 };
+
+struct load_state
+{
+    enum : uint32
+    {
+        decoding,
+        decoded,
+        creating,
+        failed,
+    };
+};
+
+// A game file that is decoded on a background thread. Its entities are then created on the
+// main thread by update_loading(), a few at a time.
+struct async_load
+{
+    std::filesystem::path                   path;
+    // The name of the file in the game package, or empty for absolute paths.
+    std::string                             name;
+    load_progress_callback                  on_progress{ nullptr };
+    load_complete_callback                  on_complete{ nullptr };
+    void*                                   user_data{ nullptr };
+    decoded_game                            game;
+    std::thread                             thread;
+    std::atomic<uint32>                     state{ load_state::decoding };
+    uint32                                  next_entity{ 0 };
+};
+
+// NOTE: a deque doesn't move its items, so the decode threads can keep pointers to their loads.
+utl::deque<async_load> async_loads;
+// The clock is checked after creating this many entities, not after every entity.
+constexpr uint32 entities_per_time_check{ 16 };
+
+bool read_transform(const uint8*& data, const uint8* end, uint32 entity_index, decoded_game& game)
+{
+    // NOTE: v1 files store rotations as Euler angles. Only the transform records of the
+    //       versioned layout hold packed quaternions.
     using namespace DirectX;
     float rotation[3];
+    transform::init_info& info{ game.transform_infos[entity_index] };
 
-    assert(!info.transform);
-	memcpy(&transform_info.position[0], data, sizeof(transform_info.position)); data += sizeof(transform_info.position);
+    if (game.entity_infos[entity_index].transform) return false;
+    if ((uint64)(end - data) < sizeof(info.position) + sizeof(rotation) + sizeof(info.scale)) return false;
+	memcpy(&info.position[0], data, sizeof(info.position)); data += sizeof(info.position);
 	memcpy(&rotation[0], data, sizeof(rotation)); data += sizeof(rotation);
-	memcpy(&transform_info.scale[0], data, sizeof(transform_info.scale)); data += sizeof(transform_info.scale);
+	memcpy(&info.scale[0], data, sizeof(info.scale)); data += sizeof(info.scale);
 
     XMFLOAT3A rot{ &rotation[0] };
     XMVECTOR quat{ XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3A(&rot)) };
     XMFLOAT4A rot_quat{};
     XMStoreFloat4A(&rot_quat, quat);
-    memcpy(&transform_info.rotation[0], &rot_quat.x, sizeof(transform_info.rotation));
+    memcpy(&info.rotation[0], &rot_quat.x, sizeof(info.rotation));
 
-    info.transform = &transform_info;
+    game.entity_infos[entity_index].transform = &info;
 
     return true;
 }
 
-bool read_script(const uint8*& data, game_entity::entity_info& info)
+bool read_script(const uint8*& data, const uint8* end, uint32 entity_index, decoded_game& game)
 {
-    assert(!info.script);
-    const uint32 name_length{ *data }; data += sizeof(uint32);
-    if (!name_length) return false;
-    
-    assert(name_length < 256);
-    char script_name[256];
-    memcpy(&script_name[0], data, name_length); data += name_length;
+    if (game.script_indices[entity_index] != uint32_invalid_id) return false;
+    if ((uint64)(end - data) < sizeof(uint32)) return false;
+    const uint32 name_length{ *(const uint32*)data }; data += sizeof(uint32);
+    if (!name_length || name_length >= 256 || (uint64)(end - data) < name_length) return false;
+
+    const char *const name{ (const char*)data };
+    data += name_length;
 
-    script_name[name_length] = 0;
-    script_info.script_creator = script::detail::get_script_creator(script::detail::string_hash()(script_name));
+    // NOTE: v1 files store the script name with every entity. The name is looked up in the
+    //       names seen so far, newest first, because entities with the same script tend to
+    //       come in runs. Only new names are hashed and their types are resolved once.
+    uint32 index{ (uint32)game.script_names.size() };
+    while (index)
+    {
+        const script_name& known{ game.script_names[index - 1] };
+        if (known.length == name_length && !memcmp(&game.script_name_chars[known.offset], name, name_length)) break;
+        --index;
+    }
+
+    if (!index)
+    {
+        const uint32 offset{ (uint32)game.script_name_chars.size() };
+        game.script_name_chars.resize(offset + name_length);
+        memcpy(&game.script_name_chars[offset], name, name_length);
+        game.script_names.emplace_back(script_name{ offset, name_length });
+        game.script_hashes.emplace_back(script::detail::hash_script_name(name, name_length));
+        index = (uint32)game.script_hashes.size();
+    }
 
-    info.script = &script_info;
-    return script_info.script_creator != nullptr;
+    game.script_indices[entity_index] = index - 1;
+    return true;
 }
 
-using component_reader = bool(*)(const uint8*&, game_entity::entity_info&);
+using component_reader = bool(*)(const uint8*&, const uint8*, uint32, decoded_game&);
 
 component_reader component_readers[]
 {
@@ -75,58 +273,419 @@ component_reader component_readers[]
 
 static_assert(_countof(component_readers) == component_type::count);
 
-} // anonymous namespace
+// Reads the entity at 'at' into 'game' and moves 'at' to the next entity. Returns false if
+// the entity is broken or doesn't end before 'end'.
+bool read_entity(const uint8*& at, const uint8* end, uint32 entity_index, decoded_game& game)
+{
+    constexpr uint32 su32{ sizeof(uint32) };
+    if ((uint64)(end - at) < 2 * su32) return false;
+    const uint32 flags{ *(const uint32*)at }; at += su32;
+    const uint32 num_components{ *(const uint32*)at }; at += su32;
+    if (!num_components) return false;
+
+    for (uint32 component_index{ 0 }; component_index < num_components; ++component_index)
+    {
+        if ((uint64)(end - at) < su32) return false;
+        const uint32 component_type{ *(const uint32*)at }; at += su32;
+        if (component_type >= component_type::count) return false;
+        if (!component_readers[component_type](at, end, entity_index, game)) return false;
+    }
 
+    game_entity::entity_info& info{ game.entity_infos[entity_index] };
+    if (!info.transform) return false;
+    game.transform_infos[entity_index].is_static = (flags & entity_flags::is_static) != 0;
+    info.bounds = &bounds_info;
+    return true;
+}
 
+void resize_game(decoded_game& game, uint32 entity_count)
+{
+    game.entity_infos.resize(entity_count);
+    game.transform_infos.resize(entity_count);
+    game.script_indices.resize(entity_count, uint32_invalid_id);
+}
 
-bool load_game()
+// NOTE: v1 files are still read entity by entity on one thread, because an entity's offset
+//       is only known after reading the entities before it. Their script names are matched
+//       against a table instead of hashed for every entity, but they are still compared
+//       byte by byte. The editor writes the current version every time it runs the game, so
+//       only files written by older editors take this path.
+bool decode_game_v1(game_file& file, decoded_game& game)
 {
-    //set the working directory to the executable path
-    wchar_t path[MAX_PATH];
-    const uint32 length{ GetModuleFileName(0, &path[0], MAX_PATH) };
-    if (!length || GetLastError() == ERROR_INSUFFICIENT_BUFFER) return false;
-    std::filesystem::path p{ path };
-    SetCurrentDirectory(p.parent_path().wstring().c_str());
-
-    // read game.bin and create the entities
-    std::ifstream game("game.bin", std::ios::in | std::ios::binary);
-    utl::vector<uint8> buffer(std::istreambuf_iterator<char>(game), {});
-    assert(buffer.size());
-    const uint8* at{ buffer.data() };
+    const uint8 *const begin{ file.data };
+    const uint8 *const end{ begin + file.size };
+    const uint8* at{ begin };
     constexpr uint32 su32{ sizeof(uint32) };
-    const uint32 num_entities{ *at }; at += su32;
-    if (!num_entities) return false;
-    
+    const uint32 num_entities{ *(const uint32*)at }; at += su32;
+    // NOTE: the smallest entity is its flags, a component count of 1 and a transform.
+    constexpr uint64 min_entity_size{ 3 * su32 + 9 * sizeof(float) };
+    if (!num_entities || num_entities > (file.size - su32) / min_entity_size) return false;
+
+    resize_game(game, num_entities);
+    uint64 released{ 0 };
     for (uint32 entity_index{ 0 }; entity_index < num_entities; ++entity_index)
     {
-        game_entity::entity_info  info{};
-        const uint32 entity_type{ *at }; at += su32;
-        const uint32 num_components{ *at }; at += su32;
-        if (!num_components) return false;
+        if (!read_entity(at, end, entity_index, game)) return false;
+
+        // NOTE: the entities are copied out of the file, so the pages that were parsed can
+        //       be released right away.
+        const uint64 parsed{ (uint64)(at - begin) };
+        if (file.mapping.isOpen() && parsed - released >= release_step)
+        {
+            file.mapping.release(released, parsed - released);
+            released = parsed;
+        }
+    }
+
+    // A file with data after the last entity isn't a v1 file either.
+    return at == end;
+}
+
+// Decodes the entities [begin, end) of a v2 file. Used as a job function by parallel_for().
+void decode_entities(uint32 begin, uint32 end, void* context)
+{
+    decode_context& ctx{ *(decode_context*)context };
+    decoded_game& game{ *ctx.game };
+    for (uint32 i{ begin }; i < end; ++i)
+    {
+        const entity_record& record{ ctx.entity_records[i] };
+        game_entity::entity_info& info{ game.entity_infos[i] };
+        if (!(record.components & (1u << component_type::transform)) || record.transform_index >= ctx.transform_count)
+        {
+            ctx.is_valid = false;
+            return;
+        }
+
+        const transform_record& data{ ctx.transform_records[record.transform_index] };
+        transform::init_info& transform{ game.transform_infos[i] };
+        memcpy(&transform.position[0], &data.position[0], sizeof(transform.position));
+        memcpy(&transform.scale[0], &data.scale[0], sizeof(transform.scale));
+        const math::Vec4F quat{ math::unpackQuaternion48(data.rotation) };
+        memcpy(&transform.rotation[0], &quat.x, sizeof(transform.rotation));
+        transform.is_static = (record.flags & entity_flags::is_static) != 0;
+        info.transform = &transform;
+        info.bounds = &bounds_info;
+
+        if (record.components & (1u << component_type::script))
+        {
+            if (record.script_index >= ctx.script_count)
+            {
+                ctx.is_valid = false;
+                return;
+            }
+            game.script_indices[i] = record.script_index;
+        }
+    }
+}
+
+bool decode_game_v2(const game_file& file, decoded_game& game)
+{
+    const uint8 *const begin{ file.data };
+    const uint64 file_size{ file.size };
+    const game_bin_header& header{ *(const game_bin_header*)begin };
+    if (header.version < game_bin_min_version || header.version > game_bin_version || !header.entity_count) return false;
+    if (sizeof(game_bin_header) + (uint64)header.section_count * sizeof(game_bin_section) > file_size) return false;
+
+    const game_bin_section* sections[section_type::count]{};
+    const game_bin_section *const table{ (const game_bin_section*)(begin + sizeof(game_bin_header)) };
+    for (uint32 i{ 0 }; i < header.section_count; ++i)
+    {
+        const game_bin_section& section{ table[i] };
+        if ((section.offset & 0xf) || (uint64)section.offset + section.size > file_size) return false;
+        // NOTE: unknown sections are skipped, so that newer tools can add data older engines ignore.
+        if (section.type < section_type::count) sections[section.type] = &section;
+    }
+
+    const game_bin_section *const entity_section{ sections[section_type::entities] };
+    const game_bin_section *const transform_section{ sections[section_type::transforms] };
+    if (!entity_section || !transform_section) return false;
+    if (entity_section->count != header.entity_count ||
+        (uint64)entity_section->count * sizeof(entity_record) > entity_section->size ||
+        (uint64)transform_section->count * sizeof(transform_record) > transform_section->size) return false;
+
+    if (const game_bin_section *const script_section{ sections[section_type::scripts] })
+    {
+        if ((uint64)script_section->count * sizeof(script_record) > script_section->size) return false;
+
+        const game_bin_section *const name_section{ sections[section_type::names] };
+        const bool has_hashes{ header.version >= 3 };
+        if (!has_hashes && !name_section) return false;
+
+        const script_record *const records{ (const script_record*)(begin + script_section->offset) };
+        game.script_hashes.resize(script_section->count);
+        for (uint32 i{ 0 }; i < script_section->count; ++i)
+        {
+            const script_record& record{ records[i] };
+            uint64 name_hash{ record.name_hash };
+            if (!has_hashes)
+            {
+                const char *const names{ (const char*)(begin + name_section->offset) };
+                if (!record.name.name_length || (uint64)record.name.name_offset + record.name.name_length > name_section->size) return false;
+                name_hash = script::detail::hash_script_name(names + record.name.name_offset, record.name.name_length);
+            }
+
+            game.script_hashes[i] = name_hash;
+        }
+    }
+
+    const uint32 entity_count{ header.entity_count };
+    resize_game(game, entity_count);
+    decode_context context{};
+    context.entity_records = (const entity_record*)(begin + entity_section->offset);
+    context.transform_records = (const transform_record*)(begin + transform_section->offset);
+    context.transform_count = transform_section->count;
+    context.script_count = (uint32)game.script_hashes.size();
+    context.game = &game;
+    jobs::parallel_for(entity_count, min_decode_batch_size, decode_entities, &context);
+    return context.is_valid;
+}
+
+// Decodes the game file 'file' into 'game'. Can be called from any thread.
+bool decode_game(game_file& file, decoded_game& game)
+{
+    if (file.size < sizeof(uint32)) return false;
+    const bool is_v2{ file.size >= sizeof(game_bin_header) && *(const uint32*)file.data == game_bin_magic };
+    if (!(is_v2 ? decode_game_v2(file, game) : decode_game_v1(file, game))) return false;
+
+    // NOTE: dynamic entities are created first and static ones after them. In an empty world
+    //       the dynamic entities then get neighbouring ids, so the transforms that move each
+    //       frame are close together in memory. This is only an order: both kinds still share
+    //       the same arrays (see transform::init_info::is_static).
+    const uint32 entity_count{ (uint32)game.entity_infos.size() };
+    game.creation_order.reserve(entity_count);
+    for (uint32 pass{ 0 }; pass < 2; ++pass)
+    {
+        const bool is_static{ pass == 1 };
+        for (uint32 i{ 0 }; i < entity_count; ++i)
+        {
+            if (game.transform_infos[i].is_static == is_static) game.creation_order.emplace_back(i);
+        }
+    }
+
+    return true;
+}
+
+// Looks up the script types of a decoded game. Must be called on the main thread.
+bool resolve_scripts(decoded_game& game)
+{
+    game.script_infos.resize(game.script_hashes.size());
+    for (uint32 i{ 0 }; i < game.script_hashes.size(); ++i)
+    {
+        game.script_infos[i].script_creator = script::detail::get_script_creator(game.script_hashes[i]);
+        if (!game.script_infos[i].script_creator) return false;
+    }
+
+    for (uint32 i{ 0 }; i < game.entity_infos.size(); ++i)
+    {
+        const uint32 script_index{ game.script_indices[i] };
+        if (script_index != uint32_invalid_id) game.entity_infos[i].script = &game.script_infos[script_index];
+    }
+
+    return true;
+}
+
+bool create_entity(const game_entity::entity_info& info)
+{
+    game_entity::entity entity{ game_entity::create(info) };
+    if (!entity.is_valid()) return false;
+    entities.emplace_back(entity);
+    return true;
+}
+
+std::filesystem::path executable_directory()
+{
+    wchar_t path[MAX_PATH];
+    const uint32 length{ GetModuleFileName(0, &path[0], MAX_PATH) };
+    if (!length || GetLastError() == ERROR_INSUFFICIENT_BUFFER) return {};
+    return std::filesystem::path{ path }.parent_path();
+}
+
+// Opens the game package next to the executable, if there is one.
+void open_game_package(const std::filesystem::path& directory)
+{
+    if (game_package.is_open()) return;
+    game_package.open((directory / game_package_name).string().c_str());
+}
+
+// Reads the file called 'name' from the game package or, if it isn't in there, maps the file
+// at 'path'. Can be called from any thread.
+bool open_game_file(const char* name, const std::filesystem::path& path, game_file& file)
+{
+    const uint32 index{ name && game_package.is_open() ? game_package.find(name) : uint32_invalid_id };
+    if (index != uint32_invalid_id)
+    {
+        file.buffer.resize(game_package.file_size(index));
+        if (file.buffer.empty() || !game_package.read(index, file.buffer.data())) return false;
+        file.data = file.buffer.data();
+        file.size = file.buffer.size();
+        return true;
+    }
+
+    if (!file.mapping.open(path.string().c_str())) return false;
+    file.data = file.mapping.data();
+    file.size = file.mapping.size();
+    return true;
+}
+
+void decode_async(async_load* load)
+{
+    game_file file{};
+    const char *const name{ load->name.empty() ? nullptr : load->name.c_str() };
+    const bool succeeded{ open_game_file(name, load->path, file) && decode_game(file, load->game) };
+    load->state.store(succeeded ? load_state::decoded : load_state::failed, std::memory_order_release);
+}
 
-        for (uint32 component_index{ 0 }; component_index < num_components; ++component_index)
+// Calls the callbacks of the oldest load and removes it. The entities of a failed load are
+// removed again, so that a level is either loaded completely or not at all.
+void finish_async_load(bool succeeded)
+{
+    async_load& load{ async_loads.front() };
+    load.thread.join();
+    if (!succeeded)
+    {
+        // NOTE: the loads create their entities one after another, so the entities of this
+        //       load are the last ones in 'entities'. Scripts run between the frames of a
+        //       load, so some of them may already have been removed.
+        const uint32 first_entity{ (uint32)entities.size() - load.next_entity };
+        for (uint32 i{ first_entity }; i < entities.size(); ++i)
         {
-            const uint32 component_type{ *at }; at += su32;
-            assert(component_type < component_type::count);
-            if (!component_readers[component_type](at, info)) return false;
+            const game_entity::entity_id id{ entities[i].get_id() };
+            if (game_entity::is_alive(id)) game_entity::remove(id);
         }
+        entities.resize(first_entity);
+    }
+    else if (load.on_progress)
+    {
+        load.on_progress(1.f, load.user_data);
+    }
+
+    const load_complete_callback on_complete{ load.on_complete };
+    void *const user_data{ load.user_data };
+    async_loads.pop_front();
+    if (on_complete) on_complete(succeeded, user_data);
+}
+
+} // anonymous namespace
+
+
+
+bool load_game()
+{
+    //set the working directory to the executable path
+    const std::filesystem::path directory{ executable_directory() };
+    if (directory.empty()) return false;
+    SetCurrentDirectory(directory.wstring().c_str());
+
+    // read game.bin and decode it before creating the entities
+    open_game_package(directory);
+    decoded_game game{};
+    {
+        game_file file{};
+        if (!open_game_file("game.bin", directory / "game.bin", file) || !decode_game(file, game)) return false;
+    }
+
+    if (!resolve_scripts(game)) return false;
+    for (uint32 i{ 0 }; i < game.creation_order.size(); ++i)
+    {
+        if (!create_entity(game.entity_infos[game.creation_order[i]])) return false;
+    }
+
+    return true;
+}
 
-        assert(info.transform);
-        game_entity::entity entity{ game_entity::create(info) };
-        if (!entity.is_valid()) return false;
-        entities.emplace_back(entity);
+bool load_game_async(const char* path, load_progress_callback on_progress, load_complete_callback on_complete, void* user_data)
+{
+    assert(path);
+    std::filesystem::path file{ path };
+    // NOTE: files in the game package are found by the relative path they were packed with.
+    std::string name{};
+    if (file.is_relative())
+    {
+        const std::filesystem::path directory{ executable_directory() };
+        if (directory.empty()) return false;
+        open_game_package(directory);
+        name = file.generic_string();
+        file = directory / file;
     }
 
-    assert(at == buffer.data() + buffer.size());
+    async_load& load{ async_loads.emplace_back() };
+    load.path = file;
+    load.name = std::move(name);
+    load.on_progress = on_progress;
+    load.on_complete = on_complete;
+    load.user_data = user_data;
+    load.thread = std::thread{ decode_async, &load };
     return true;
 }
 
+void update_loading(uint32 budget_us)
+{
+    using clock = std::chrono::steady_clock;
+    const clock::time_point end_time{ clock::now() + std::chrono::microseconds{ budget_us } };
+
+    // NOTE: the loads are finished in the order they were started. The next load is started
+    //       in the same frame if there's time left.
+    while (async_loads.size())
+    {
+        async_load& load{ async_loads.front() };
+        uint32 state{ load.state.load(std::memory_order_acquire) };
+        if (state == load_state::decoding) return;
+        if (state == load_state::decoded)
+        {
+            state = resolve_scripts(load.game) ? load_state::creating : load_state::failed;
+            load.state.store(state, std::memory_order_relaxed);
+        }
+
+        bool succeeded{ state == load_state::creating };
+        const uint32 count{ (uint32)load.game.creation_order.size() };
+        while (succeeded && load.next_entity < count)
+        {
+            const uint32 last{ count - load.next_entity > entities_per_time_check ? load.next_entity + entities_per_time_check : count };
+            for (; load.next_entity < last; ++load.next_entity)
+            {
+                if (!create_entity(load.game.entity_infos[load.game.creation_order[load.next_entity]]))
+                {
+                    succeeded = false;
+                    break;
+                }
+            }
+
+            if (clock::now() >= end_time) break;
+        }
+
+        if (succeeded && load.next_entity < count)
+        {
+            if (load.on_progress) load.on_progress((float)load.next_entity / (float)count, load.user_data);
+            return;
+        }
+
+        finish_async_load(succeeded);
+        if (clock::now() >= end_time) return;
+    }
+}
+
+bool is_loading()
+{
+    return async_loads.size() != 0;
+}
+
 void unload_game()
 {
+    // NOTE: decoding can't be interrupted, but it doesn't create anything either. So, the
+    //       pending loads just wait for their threads and are dropped.
+    for (uint32 i{ 0 }; i < async_loads.size(); ++i)
+    {
+        async_loads[i].thread.join();
+    }
+    async_loads.clear();
+
+    // NOTE: restoring a world snapshot can replace the loaded entities.
     for (auto entity : entities)
     {
-        game_entity::remove(entity.get_id());
+        if (game_entity::is_alive(entity.get_id())) game_entity::remove(entity.get_id());
     }
+    entities.clear();
+    game_package.close();
 }
 
 }
@@ -7,7 +7,21 @@
 
 namespace zone::content {
 
+// Called on the main thread while a game file is loading. 'progress' is the part of its
+// entities that has been created so far, from 0 to 1.
+using load_progress_callback = void(*)(float progress, void* user_data);
+// Called on the main thread once a game file has been loaded, or has failed to load.
+using load_complete_callback = void(*)(bool succeeded, void* user_data);
+
 bool load_game();
+// Starts loading the game file at 'path' in the background. Relative paths are relative to
+// the executable. The file is read and decoded on another thread and its entities are created
+// by update_loading(). Returns false if the load couldn't be started.
+bool load_game_async(const char* path, load_progress_callback on_progress, load_complete_callback on_complete, void* user_data);
+// Creates the entities of decoded game files for about 'budget_us' microseconds and calls the
+// callbacks. Must be called once per frame on the main thread, while no scripts are running.
+void update_loading(uint32 budget_us);
+bool is_loading();
 void unload_game();
 
 }
@@ -0,0 +1,135 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#include "GeometryLoader.h"
+#include "Package.h"
+
+namespace zone::content {
+namespace {
+
+// NOTE: the layout of a geometry blob, as written by tools::packData(). All counts and sizes
+//		 are uint32 and nothing is padded:
+//			scene name length, scene name, LOD group count
+//			per LOD group:	name length, name, mesh count
+//			per mesh:		name length, name, LOD id, vertex size, vertex count, index size,
+//							index count, LOD threshold (float), vertices, indices
+constexpr uint32 su32{ sizeof(uint32) };
+constexpr uint32 mesh_header_size{ 6 * su32 };
+
+uint32 read_uint32(const uint8*& at)
+{
+	uint32 value;
+	memcpy(&value, at, su32); at += su32;
+	return value;
+}
+
+// Moves 'at' over a name and returns it. The caller checks that the name is in the blob.
+const char* read_name(const uint8*& at, uint32& length)
+{
+	length = read_uint32(at);
+	const char *const name{ (const char*)at };
+	at += length;
+	return name;
+}
+
+bool has_bytes(const uint8* at, const uint8* end, uint64 size)
+{
+	return at <= end && (uint64)(end - at) >= size;
+}
+} // anonymous namespace
+
+bool get_geometry_info(const uint8* data, uint64 size, geometry_info& info)
+{
+	assert(data);
+	const uint8* at{ data };
+	const uint8 *const end{ data + size };
+	info = {};
+
+	uint32 name_length;
+	if (!has_bytes(at, end, su32)) return false;
+	memcpy(&name_length, at, su32);
+	if (!has_bytes(at, end, (uint64)su32 + name_length + su32)) return false;
+	info.name = read_name(at, info.name_length);
+	info.lod_count = read_uint32(at);
+
+	for (uint32 lod_index{ 0 }; lod_index < info.lod_count; ++lod_index)
+	{
+		if (!has_bytes(at, end, su32)) return false;
+		memcpy(&name_length, at, su32);
+		if (!has_bytes(at, end, (uint64)su32 + name_length + su32)) return false;
+		read_name(at, name_length);
+		const uint32 mesh_count{ read_uint32(at) };
+
+		for (uint32 mesh_index{ 0 }; mesh_index < mesh_count; ++mesh_index)
+		{
+			if (!has_bytes(at, end, su32)) return false;
+			memcpy(&name_length, at, su32);
+			if (!has_bytes(at, end, (uint64)su32 + name_length + mesh_header_size)) return false;
+			read_name(at, name_length);
+
+			read_uint32(at); // LOD id
+			const uint32 vertex_size{ read_uint32(at) };
+			const uint32 vertex_count{ read_uint32(at) };
+			const uint32 index_size{ read_uint32(at) };
+			const uint32 index_count{ read_uint32(at) };
+			at += sizeof(float); // LOD threshold
+
+			if (!vertex_size || (index_size != sizeof(uint16) && index_size != sizeof(uint32))) return false;
+			const uint64 data_size{ (uint64)vertex_size * vertex_count + (uint64)index_size * index_count };
+			if (!has_bytes(at, end, data_size)) return false;
+			at += data_size;
+		}
+
+		info.mesh_count += mesh_count;
+	}
+
+	// NOTE: packData() writes exactly the size it computed, so anything left over means the
+	//		 blob isn't what we think it is.
+	return at == end;
+}
+
+void read_geometry(const uint8* data, lod_group_view* lods, mesh_view* meshes)
+{
+	assert(data && lods && meshes);
+	const uint8* at{ data };
+	uint32 name_length;
+	read_name(at, name_length);
+	const uint32 lod_count{ read_uint32(at) };
+
+	uint32 mesh_index{ 0 };
+	for (uint32 lod_index{ 0 }; lod_index < lod_count; ++lod_index)
+	{
+		lod_group_view& lod{ lods[lod_index] };
+		lod.name = read_name(at, lod.name_length);
+		lod.mesh_count = read_uint32(at);
+		lod.first_mesh = mesh_index;
+
+		for (uint32 i{ 0 }; i < lod.mesh_count; ++i, ++mesh_index)
+		{
+			mesh_view& mesh{ meshes[mesh_index] };
+			mesh.name = read_name(at, mesh.name_length);
+			mesh.lod_id = read_uint32(at);
+			mesh.vertex_size = read_uint32(at);
+			mesh.vertex_count = read_uint32(at);
+			mesh.index_size = read_uint32(at);
+			mesh.index_count = read_uint32(at);
+			memcpy(&mesh.lod_threshold, at, sizeof(float)); at += sizeof(float);
+
+			mesh.vertices = at; at += (uint64)mesh.vertex_size * mesh.vertex_count;
+			mesh.indices = at; at += (uint64)mesh.index_size * mesh.index_count;
+		}
+	}
+}
+
+bool load_geometry(const package& source, const char* name, utl::vector<uint8>& blob, geometry_info& info)
+{
+	assert(name);
+	const uint32 index{ source.is_open() ? source.find(name) : uint32_invalid_id };
+	if (index == uint32_invalid_id) return false;
+
+	blob.resize(source.file_size(index));
+	if (blob.empty() || !source.read(index, blob.data())) return false;
+	return get_geometry_info(blob.data(), blob.size(), info);
+}
+
+}
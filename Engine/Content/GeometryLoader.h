@@ -0,0 +1,55 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "CommonHeaders.h"
+
+namespace zone::content {
+
+class package;
+
+// A mesh in a geometry blob written by tools::packData(). The names, vertices and indices
+// point into the blob, so they're only valid while the blob is. They aren't aligned.
+struct mesh_view
+{
+	const char*								name;
+	const void*								vertices;
+	const void*								indices;
+	uint32									name_length;
+	uint32									lod_id;
+	uint32									vertex_size;
+	uint32									vertex_count;
+	// 2 for 16-bit and 4 for 32-bit indices.
+	uint32									index_size;
+	uint32									index_count;
+	float									lod_threshold;
+};
+
+// A LOD group owns the meshes [first_mesh, first_mesh + mesh_count).
+struct lod_group_view
+{
+	const char*								name;
+	uint32									name_length;
+	uint32									first_mesh;
+	uint32									mesh_count;
+};
+
+struct geometry_info
+{
+	const char*								name;
+	uint32									name_length;
+	uint32									lod_count;
+	uint32									mesh_count;
+};
+
+// Checks that the 'size' bytes at 'data' are a complete geometry blob and gets its name and
+// the number of LOD groups and meshes.
+bool get_geometry_info(const uint8* data, uint64 size, geometry_info& info);
+// Fills 'lods' and 'meshes' with views into a blob that passed get_geometry_info(). The
+// arrays must have room for info.lod_count and info.mesh_count items. Nothing is copied or
+// allocated, so the caller can reuse the same arrays for every blob.
+void read_geometry(const uint8* data, lod_group_view* lods, mesh_view* meshes);
+// Reads the geometry blob called 'name' from 'source' into 'blob' and checks it with
+// get_geometry_info(). 'blob' can be reused for the next geometry.
+bool load_geometry(const package& source, const char* name, utl::vector<uint8>& blob, geometry_info& info);
+
+}
@@ -0,0 +1,269 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#include "Package.h"
+#include "..\Core\JobSystem.h"
+#include "..\Utilities\Compression.h"
+#include "..\Platform\AsyncIO.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+namespace zone::content {
+namespace {
+
+// Blocks of a file that are read from disk at the same time. Compressed blocks are read into
+// one staging slot of block_size bytes each, so a read needs at most this many slots.
+constexpr uint32 max_blocks_in_flight{ 32 };
+
+struct read_context
+{
+	const uint8*							data;
+	const package_block*					blocks;
+	// Where the compressed blocks were read to, or null when they're read from the mapping.
+	// A null source means the block was stored and is already in the buffer.
+	const uint8* const*						sources;
+	// The blocks to decompress, or null for all blocks of the file.
+	const uint32*							indices;
+	uint8*									buffer;
+	uint32									block_size;
+	std::atomic<bool>						is_valid{ true };
+};
+
+// The blocks of a file whose reads have finished and that weren't decompressed yet.
+struct arrived_blocks
+{
+	std::mutex								mutex;
+	std::condition_variable					cv;
+	utl::vector<uint32>						indices;
+	bool									succeeded{ true };
+};
+
+struct block_read
+{
+	arrived_blocks*							arrived;
+	uint32									index;
+	uint32									size;
+};
+
+void on_block_read(void* context, bool succeeded, uint32 bytes_read)
+{
+	const block_read& read{ *(const block_read*)context };
+	arrived_blocks& arrived{ *read.arrived };
+	std::lock_guard lock{ arrived.mutex };
+	if (!succeeded || bytes_read != read.size) arrived.succeeded = false;
+	arrived.indices.emplace_back(read.index);
+	arrived.cv.notify_one();
+}
+
+// Decompresses the blocks [begin, end) of a file. Used as a job function by parallel_for().
+void read_blocks(uint32 begin, uint32 end, void* context)
+{
+	read_context& ctx{ *(read_context*)context };
+	for (uint32 n{ begin }; n < end; ++n)
+	{
+		const uint32 i{ ctx.indices ? ctx.indices[n] : n };
+		const package_block& block{ ctx.blocks[i] };
+		const uint8 *const data{ ctx.sources ? ctx.sources[i] : ctx.data + block.offset };
+		uint8 *const out{ ctx.buffer + (uint64)i * ctx.block_size };
+		if (!data) continue;
+		if (block.compressed_size == block.size)
+		{
+			memcpy(out, data, block.size);
+		}
+		else if (!utl::lz_decompress(data, block.compressed_size, out, block.size))
+		{
+			ctx.is_valid = false;
+			return;
+		}
+	}
+}
+} // anonymous namespace
+
+bool package::open(const char* path)
+{
+	close();
+	// NOTE: the blocks are read in any order, so there's no point in asking for read-ahead.
+	if (!_file.open(path, false)) return false;
+
+	const uint8 *const data{ _file.data() };
+	const uint64 size{ _file.size() };
+	if (size < sizeof(package_header)) return false;
+
+	const package_header& header{ *(const package_header*)data };
+	if (header.magic != package_magic || header.version != package_version ||
+		header.block_size < package_min_block_size || header.block_size > package_max_block_size) return false;
+
+	const uint64 directory_size{ (uint64)header.file_count * sizeof(package_file) + (uint64)header.block_count * sizeof(package_block) };
+	if (sizeof(package_header) + directory_size > size) return false;
+
+	const package_file *const files{ (const package_file*)(data + sizeof(package_header)) };
+	const package_block *const blocks{ (const package_block*)(files + header.file_count) };
+	for (uint32 i{ 0 }; i < header.block_count; ++i)
+	{
+		const package_block& block{ blocks[i] };
+		if (block.size > header.block_size || block.compressed_size > block.size ||
+			block.offset > size || block.compressed_size > size - block.offset) return false;
+	}
+
+	for (uint32 i{ 0 }; i < header.file_count; ++i)
+	{
+		const package_file& file{ files[i] };
+		if (i && files[i - 1].name_hash >= file.name_hash) return false;
+		if ((uint64)file.first_block + file.block_count > header.block_count) return false;
+
+		// NOTE: only the last block of a file can be shorter, so that block 'i' of a file
+		//		 always starts at i * block_size in the output.
+		uint64 file_size{ 0 };
+		for (uint32 b{ 0 }; b < file.block_count; ++b)
+		{
+			const package_block& block{ blocks[file.first_block + b] };
+			if (b + 1 < file.block_count && block.size != header.block_size) return false;
+			file_size += block.size;
+		}
+		if (file_size != file.size) return false;
+	}
+
+	_files = files;
+	_blocks = blocks;
+	_file_count = header.file_count;
+	_block_size = header.block_size;
+	if (platform::asyncIOBackend() != platform::AsyncIOBackend::none)
+	{
+		_async_file = platform::openAsyncFile(path);
+	}
+	return true;
+}
+
+void package::close()
+{
+	if (_async_file != uint32_invalid_id)
+	{
+		platform::closeAsyncFile(_async_file);
+		_async_file = uint32_invalid_id;
+	}
+	_file.close();
+	_files = nullptr;
+	_blocks = nullptr;
+	_file_count = 0;
+	_block_size = 0;
+}
+
+uint32 package::find(const char* name) const
+{
+	assert(name);
+	const uint64 name_hash{ hash_package_name(name) };
+	uint32 first{ 0 };
+	uint32 last{ _file_count };
+	while (first < last)
+	{
+		const uint32 middle{ first + (last - first) / 2 };
+		if (_files[middle].name_hash < name_hash) first = middle + 1;
+		else last = middle;
+	}
+
+	return first < _file_count && _files[first].name_hash == name_hash ? first : uint32_invalid_id;
+}
+
+uint64 package::file_size(uint32 index) const
+{
+	assert(index < _file_count);
+	return _files[index].size;
+}
+
+bool package::read(uint32 index, uint8* buffer) const
+{
+	assert(index < _file_count && buffer);
+	const package_file& file{ _files[index] };
+	read_context context{};
+	context.data = _file.data();
+	context.blocks = _blocks + file.first_block;
+	context.buffer = buffer;
+	context.block_size = _block_size;
+
+	if (_async_file == uint32_invalid_id || !file.block_count)
+	{
+		jobs::parallel_for(file.block_count, 1, read_blocks, &context);
+		return context.is_valid;
+	}
+
+	// NOTE: reading the blocks through the mapping faults them in one page at a time on each
+	//		 worker. With async I/O up to max_blocks_in_flight blocks are read at once, so the
+	//		 disk sees a deep queue. The blocks that have arrived are decompressed on the worker
+	//		 threads while the next ones are read, and their staging slots are then reused.
+	//		 Stored blocks are read straight into 'buffer' and only take a slot while in flight.
+	const uint32 slot_count{ std::min(file.block_count, max_blocks_in_flight) };
+	utl::vector<uint8> staging((uint64)slot_count * _block_size);
+	utl::vector<uint32> free_slots(slot_count);
+	for (uint32 i{ 0 }; i < slot_count; ++i) free_slots[i] = slot_count - 1 - i;
+	utl::vector<uint32> block_slots(file.block_count);
+	utl::vector<const uint8*> sources(file.block_count, nullptr);
+	utl::vector<block_read> block_reads(file.block_count);
+	utl::vector<platform::AsyncRead> reads{};
+	utl::vector<uint32> ready{};
+	arrived_blocks arrived{};
+	context.sources = sources.data();
+
+	uint32 next_block{ 0 };
+	uint32 in_flight{ 0 };
+	bool succeeded{ true };
+	while (true)
+	{
+		reads.clear();
+		while (succeeded && next_block < file.block_count && free_slots.size())
+		{
+			const uint32 i{ next_block++ };
+			const uint32 slot{ free_slots.back() };
+			free_slots.resize(free_slots.size() - 1);
+			block_slots[i] = slot;
+
+			const package_block& block{ context.blocks[i] };
+			block_reads[i] = { &arrived, i, block.compressed_size };
+			platform::AsyncRead read{};
+			read.file = _async_file;
+			read.offset = block.offset;
+			read.size = block.compressed_size;
+			read.callback = on_block_read;
+			read.context = &block_reads[i];
+			if (block.compressed_size == block.size)
+			{
+				read.buffer = buffer + (uint64)i * _block_size;
+			}
+			else
+			{
+				read.buffer = staging.data() + (uint64)slot * _block_size;
+				sources[i] = read.buffer;
+			}
+			reads.emplace_back(read);
+		}
+
+		in_flight += (uint32)reads.size();
+		if (reads.size()) platform::submitReads(reads.data(), (uint32)reads.size());
+		// NOTE: after a failed read, the reads in flight still write into 'staging' and
+		//		 'buffer', so they're waited for before returning.
+		if (!in_flight) break;
+
+		ready.clear();
+		{
+			std::unique_lock lock{ arrived.mutex };
+			arrived.cv.wait(lock, [&arrived] { return arrived.indices.size() != 0; });
+			ready.swap(arrived.indices);
+			succeeded = succeeded && arrived.succeeded;
+		}
+
+		in_flight -= (uint32)ready.size();
+		if (succeeded)
+		{
+			context.indices = ready.data();
+			jobs::parallel_for((uint32)ready.size(), 1, read_blocks, &context);
+			succeeded = context.is_valid;
+		}
+
+		for (uint32 i{ 0 }; i < ready.size(); ++i) free_slots.emplace_back(block_slots[ready[i]]);
+	}
+
+	return succeeded;
+}
+
+}
@@ -0,0 +1,41 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "PackageFormat.h"
+#include "..\Platform\MappedFile.h"
+
+namespace zone::content {
+
+// Read-only access to the files in a package (see PackageFormat.h).
+class package
+{
+public:
+	package() = default;
+	~package() { close(); }
+	DISABLE_COPY_AND_MOVE(package);
+
+	// Maps the package at 'path' and checks its directory.
+	bool open(const char* path);
+	void close();
+
+	// Returns the index of the file called 'name', or uint32_invalid_id.
+	uint32 find(const char* name) const;
+	uint64 file_size(uint32 index) const;
+	// Decompresses file 'index' into 'buffer', which must have room for file_size(index)
+	// bytes. The blocks are decompressed on the worker threads, straight into 'buffer'.
+	// When async I/O is running, the blocks are read from disk a window at a time and each
+	// one is decompressed as soon as it has arrived.
+	bool read(uint32 index, uint8* buffer) const;
+
+	constexpr bool is_open() const { return _files != nullptr; }
+	constexpr uint32 file_count() const { return _file_count; }
+private:
+	platform::MappedFile	_file{};
+	const package_file*		_files{ nullptr };
+	const package_block*	_blocks{ nullptr };
+	uint32					_file_count{ 0 };
+	uint32					_block_size{ 0 };
+	uint32					_async_file{ uint32_invalid_id };
+};
+
+}
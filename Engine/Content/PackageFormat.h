@@ -0,0 +1,56 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "CommonHeaders.h"
+
+namespace zone::content {
+
+// NOTE: layout of a package, shared by the engine and ContentTools:
+//			package_header
+//			package_file[file_count]		sorted by name hash
+//			package_block[block_count]
+//			block data
+//		 Each file is split into blocks of block_size bytes (the last one can be shorter),
+//		 which are compressed with utl::lz_compress() one by one. So, the blocks of a file
+//		 can be decompressed in parallel. Blocks that don't get smaller are stored as they are.
+constexpr uint32 package_magic{ 'Z' | ('P' << 8) | ('A' << 16) | ('K' << 24) };
+constexpr uint32 package_version{ 1 };
+constexpr uint32 package_min_block_size{ 64 * 1024 };
+constexpr uint32 package_max_block_size{ 256 * 1024 };
+constexpr uint32 package_default_block_size{ 128 * 1024 };
+
+struct package_header
+{
+	uint32									magic;
+	uint32									version;
+	uint32									block_size;
+	uint32									file_count;
+	uint32									block_count;
+	uint32									reserved[3];
+};
+
+struct package_file
+{
+	uint64									name_hash;
+	uint64									size;
+	uint32									first_block;
+	uint32									block_count;
+};
+
+struct package_block
+{
+	uint64									offset;
+	// Equal to 'size' for blocks that are stored uncompressed.
+	uint32									compressed_size;
+	uint32									size;
+};
+
+static_assert(sizeof(package_header) == 32 && sizeof(package_file) == 24 && sizeof(package_block) == 16);
+
+// 64-bit FNV-1a hash of a file name in a package.
+constexpr uint64 hash_package_name(const char* name)
+{
+	return utl::hash_fnv1a(name);
+}
+
+}
@@ -0,0 +1,291 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#include "WorldSnapshot.h"
+#include "ContentLoader.h"
+#include "..\Components\Entity.h"
+#include "..\Components\Transform.h"
+#include "..\Components\Script.h"
+#include "..\Components\Bounds.h"
+#include "..\Components\Tasks.h"
+
+namespace zone::content {
+namespace {
+
+// NOTE: world snapshot layout. Offsets are from the start of the data and every section
+//		 starts on a 16-byte boundary:
+//			world_header				magic, version and counts
+//			world_section[]				where each section is
+//			per-slot sections			one item per entity slot, copied as one block
+//			free_ids section			the entity ids waiting to be reused, in order
+//			script_types section		one script_type_record per script type and interval
+//		 Removed slots are saved too, so that the ids and generations stay the same.
+constexpr uint32 world_magic{ 'Z' | ('W' << 8) | ('L' << 16) | ('D' << 24) };
+constexpr uint32 world_version{ 1 };
+constexpr uint32 world_alignment{ 16 };
+
+struct section_type
+{
+	enum type : uint32
+	{
+		generations,
+		slot_flags,
+		positions,
+		rotations,
+		scales,
+		static_flags,
+		bounds_centers,
+		bounds_extents,
+		// Index into the script types for each slot, or uint32_invalid_id.
+		scripts,
+		free_ids,
+		script_types,
+
+		count
+	};
+};
+
+struct world_header
+{
+	uint32									magic;
+	uint32									version;
+	uint32									slot_count;
+	uint32									section_count;
+};
+
+struct world_section
+{
+	uint32									type;
+	uint32									count;
+	uint32									offset;
+	uint32									size;
+};
+
+struct script_type_record
+{
+	uint64									name_hash;
+	uint32									tick_interval;
+	uint32									reserved;
+};
+
+static_assert(sizeof(world_header) == 16 && sizeof(world_section) == 16 && sizeof(script_type_record) == 16);
+
+constexpr uint32 item_sizes[section_type::count]
+{
+	sizeof(id::generation_type),
+	sizeof(uint8),
+	sizeof(math::Vec3F),
+	sizeof(transform::rotation_storage),
+	sizeof(math::Vec3F),
+	sizeof(uint8),
+	sizeof(math::Vec3F),
+	sizeof(math::Vec3F),
+	sizeof(uint32),
+	sizeof(game_entity::entity_id),
+	sizeof(script_type_record),
+};
+
+struct script_type
+{
+	script::detail::script_creator			creator;
+	uint32									tick_interval;
+};
+
+// Scratch buffers, kept around so that restarting a level doesn't allocate.
+	utl::vector<script_type>				saved_types;
+	utl::vector<script::detail::script_creator>	restored_types;
+	utl::vector<game_entity::entity_id>		bounds_owners;
+
+uint32 align_offset(uint64 offset)
+{
+	return (uint32)((offset + world_alignment - 1) & ~(uint64)(world_alignment - 1));
+}
+
+template<typename T>
+T* section_data(uint8* data, const world_section& section)
+{
+	return (T*)(data + section.offset);
+}
+
+template<typename T>
+const T* section_data(const uint8* data, const world_section& section)
+{
+	return (const T*)(data + section.offset);
+}
+
+uint32 find_script_type(script::detail::script_creator creator, uint32 tick_interval)
+{
+	// NOTE: there are only a handful of script types, a linear search is fine here.
+	for (uint32 i{ 0 }; i < saved_types.size(); ++i)
+	{
+		if (saved_types[i].creator == creator && saved_types[i].tick_interval == tick_interval) return i;
+	}
+
+	saved_types.emplace_back(script_type{ creator, tick_interval });
+	return (uint32)saved_types.size() - 1;
+}
+} // anonymous namespace
+
+void save_world(utl::vector<uint8>& data)
+{
+	const uint32 slot_count{ game_entity::slot_count() };
+
+	// The script sections are filled last, but the number of types is needed for the layout.
+	saved_types.clear();
+	for (uint32 i{ 0 }; i < slot_count; ++i)
+	{
+		const game_entity::entity_id id{ game_entity::slot_id(i) };
+		if (!game_entity::is_alive(id)) continue;
+		const script::component script{ game_entity::entity{ id }.script() };
+		if (!script.is_valid()) continue;
+		uint32 tick_interval{ 0 };
+		const script::detail::script_creator creator{ script::get_script_type(script, tick_interval) };
+		find_script_type(creator, tick_interval);
+	}
+
+	world_section sections[section_type::count]{};
+	uint64 offset{ sizeof(world_header) + sizeof(sections) };
+	for (uint32 i{ 0 }; i < section_type::count; ++i)
+	{
+		world_section& section{ sections[i] };
+		section.type = i;
+		section.count = i == section_type::free_ids ? game_entity::free_id_count() :
+						i == section_type::script_types ? (uint32)saved_types.size() : slot_count;
+		section.offset = align_offset(offset);
+		section.size = section.count * item_sizes[i];
+		offset = (uint64)section.offset + section.size;
+	}
+	assert(offset <= uint32_invalid_id);
+
+	data.clear();
+	data.resize(offset, 0);
+	uint8 *const begin{ data.data() };
+	const world_header header{ world_magic, world_version, slot_count, section_type::count };
+	memcpy(begin, &header, sizeof(header));
+	memcpy(begin + sizeof(header), sections, sizeof(sections));
+
+	uint8 *const flags{ section_data<uint8>(begin, sections[section_type::slot_flags]) };
+	game_entity::save_registry(section_data<id::generation_type>(begin, sections[section_type::generations]), flags,
+							   section_data<game_entity::entity_id>(begin, sections[section_type::free_ids]));
+	transform::save_state(section_data<math::Vec3F>(begin, sections[section_type::positions]),
+						  section_data<transform::rotation_storage>(begin, sections[section_type::rotations]),
+						  section_data<math::Vec3F>(begin, sections[section_type::scales]),
+						  section_data<uint8>(begin, sections[section_type::static_flags]), slot_count);
+	bounds::save_state(section_data<math::Vec3F>(begin, sections[section_type::bounds_centers]),
+					   section_data<math::Vec3F>(begin, sections[section_type::bounds_extents]), slot_count);
+
+	uint32 *const scripts{ section_data<uint32>(begin, sections[section_type::scripts]) };
+	for (uint32 i{ 0 }; i < slot_count; ++i)
+	{
+		scripts[i] = uint32_invalid_id;
+		if (!(flags[i] & game_entity::slot_flags::alive)) continue;
+		const script::component script{ game_entity::entity{ game_entity::slot_id(i) }.script() };
+		if (!script.is_valid()) continue;
+		uint32 tick_interval{ 0 };
+		const script::detail::script_creator creator{ script::get_script_type(script, tick_interval) };
+		scripts[i] = find_script_type(creator, tick_interval);
+	}
+
+	script_type_record *const records{ section_data<script_type_record>(begin, sections[section_type::script_types]) };
+	for (uint32 i{ 0 }; i < saved_types.size(); ++i)
+	{
+		records[i] = { saved_types[i].creator->name_hash, saved_types[i].tick_interval, 0 };
+	}
+}
+
+bool restore_world(const uint8* data, uint64 size)
+{
+	assert(data || !size);
+#if !defined(SHIPPING)
+	// NOTE: a load that is creating entities would mix them with the restored ones.
+	assert(!is_loading());
+#endif // !defined(SHIPPING)
+	if (size < sizeof(world_header)) return false;
+	const world_header& header{ *(const world_header*)data };
+	if (header.magic != world_magic || header.version != world_version) return false;
+	if (sizeof(world_header) + (uint64)header.section_count * sizeof(world_section) > size) return false;
+
+	const world_section* sections[section_type::count]{};
+	const world_section *const table{ (const world_section*)(data + sizeof(world_header)) };
+	for (uint32 i{ 0 }; i < header.section_count; ++i)
+	{
+		const world_section& section{ table[i] };
+		if ((section.offset & (world_alignment - 1)) || (uint64)section.offset + section.size > size) return false;
+		if (section.type < section_type::count) sections[section.type] = &section;
+	}
+
+	// NOTE: the blocks are copied as they are, so their items must have the sizes of this
+	//		 build, e.g. the same rotation storage.
+	const uint32 slot_count{ header.slot_count };
+	for (uint32 i{ 0 }; i < section_type::count; ++i)
+	{
+		const world_section *const section{ sections[i] };
+		if (!section || (uint64)section->count * item_sizes[i] != section->size) return false;
+		if (i != section_type::free_ids && i != section_type::script_types && section->count != slot_count) return false;
+	}
+
+	const uint8 *const flags{ section_data<uint8>(data, *sections[section_type::slot_flags]) };
+	const uint32 *const scripts{ section_data<uint32>(data, *sections[section_type::scripts]) };
+	const game_entity::entity_id *const free_ids{ section_data<game_entity::entity_id>(data, *sections[section_type::free_ids]) };
+	const uint32 free_count{ sections[section_type::free_ids]->count };
+	const uint32 type_count{ sections[section_type::script_types]->count };
+
+	// Script types are matched by name, so the game code can be another build of the same game.
+	const script_type_record *const records{ section_data<script_type_record>(data, *sections[section_type::script_types]) };
+	restored_types.resize(type_count);
+	for (uint32 i{ 0 }; i < type_count; ++i)
+	{
+		restored_types[i] = script::detail::get_script_creator(records[i].name_hash);
+		if (!restored_types[i] || !records[i].tick_interval) return false;
+	}
+
+	for (uint32 i{ 0 }; i < slot_count; ++i)
+	{
+		const bool is_alive{ (flags[i] & game_entity::slot_flags::alive) != 0 };
+		if (!is_alive && flags[i]) return false;
+		if (scripts[i] != uint32_invalid_id && (!is_alive || scripts[i] >= type_count)) return false;
+	}
+
+	for (uint32 i{ 0 }; i < free_count; ++i)
+	{
+		if (!id::is_valid(free_ids[i]) || id::index(free_ids[i]) >= slot_count) return false;
+		if (flags[id::index(free_ids[i])] & game_entity::slot_flags::alive) return false;
+	}
+
+	// The data is valid, replace the world.
+	script::remove_entity_tasks();
+	game_entity::restore_registry(section_data<id::generation_type>(data, *sections[section_type::generations]),
+								  flags, slot_count, free_ids, free_count);
+	transform::restore_state(section_data<math::Vec3F>(data, *sections[section_type::positions]),
+							 section_data<transform::rotation_storage>(data, *sections[section_type::rotations]),
+							 section_data<math::Vec3F>(data, *sections[section_type::scales]),
+							 section_data<uint8>(data, *sections[section_type::static_flags]), slot_count);
+
+	bounds_owners.resize(slot_count);
+	for (uint32 i{ 0 }; i < slot_count; ++i)
+	{
+		bounds_owners[i] = (flags[i] & game_entity::slot_flags::has_bounds) ?
+			game_entity::slot_id(i) : game_entity::entity_id{ id::invalid_id };
+	}
+	bounds::restore_state(section_data<math::Vec3F>(data, *sections[section_type::bounds_centers]),
+						  section_data<math::Vec3F>(data, *sections[section_type::bounds_extents]),
+						  bounds_owners.data(), slot_count);
+
+	for (uint32 i{ 0 }; i < slot_count; ++i)
+	{
+		if (scripts[i] == uint32_invalid_id) continue;
+		const game_entity::entity_id id{ game_entity::slot_id(i) };
+		const script::detail::script_creator creator{ restored_types[scripts[i]] };
+		game_entity::add_script(id, script::init_info{ creator });
+
+		const uint32 tick_interval{ records[scripts[i]].tick_interval };
+		if (tick_interval != creator->tick_interval)
+		{
+			game_entity::entity{ id }.script().set_tick_interval(tick_interval);
+		}
+	}
+
+	return true;
+}
+
+}
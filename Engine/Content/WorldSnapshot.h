@@ -0,0 +1,23 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "CommonHeaders.h"
+
+namespace zone::content {
+
+// NOTE: a world snapshot holds the entity registry, the transforms, the local bounds and the
+//		 script type of each entity as raw blocks. Restoring copies the blocks back and only
+//		 creates the scripts one by one: they're constructed again and get a begin_play()
+//		 call in the next update, like the scripts of a freshly loaded game. Snapshots are
+//		 meant to be restored by the build that saved them, e.g. for level restarts, quick
+//		 saves and test fixtures.
+
+// Saves all entities into 'data', which is resized to fit.
+void save_world(utl::vector<uint8>& data);
+// Removes all entities and creates the ones saved in 'data', with the same ids. Returns false
+// without changing anything if 'data' isn't a valid snapshot or has unknown script types.
+// Must be called on the main thread between frames, after script::dispatch_events(), and not
+// while a game file is loading. Waiting tasks of the old entities are destroyed.
+bool restore_world(const uint8* data, uint64 size);
+
+}
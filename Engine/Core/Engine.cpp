@@ -3,9 +3,16 @@
 #if !defined(SHIPPING)
 #include "..\Content\ContentLoader.h"
 #include "..\Components\Script.h"
+#include "..\Components\Events.h"
+#include "..\Components\Tasks.h"
+#include "..\Components\Transform.h"
+#include "..\Components\Bounds.h"
+#include "JobSystem.h"
 #include "..\Platform\PlatformTypes.h"
 #include "..\Platform\Platform.h"
+#include "..\Platform\AsyncIO.h"
 #include "..\Graphics\Renderer.h"
+#include <chrono>
 #include <thread>
 
 using namespace zone;
@@ -14,6 +21,72 @@ namespace {
 
 graphics::RenderSurface gameWindow{};
 
+// NOTE: scripts run at a fixed rate. The rendered frame uses transforms interpolated
+//		 between the last two simulation steps.
+constexpr float simulation_step{ 1.f / 30.f };
+constexpr float max_frame_time{ 0.25f };
+float step_accumulator{ 0.f };
+std::chrono::steady_clock::time_point last_frame_time{};
+float script_report_time{ 0.f };
+// NOTE: frames are paced to this rate until the renderer presents with vsync. The game
+//		 thread waits on a high-resolution timer between frames, because Sleep() can be off
+//		 by up to 15.6 ms.
+constexpr float target_frame_time{ 1.f / 144.f };
+HANDLE frame_timer{ nullptr };
+std::chrono::steady_clock::time_point next_frame_time{};
+// NOTE: the game is loaded in the background. Its entities are created in slices of about
+//		 this many microseconds per frame, so loading doesn't stall the frame.
+constexpr uint32 load_budget_us{ 500 };
+
+void on_game_loaded(bool succeeded, void*)
+{
+	// The game can't run without its entities.
+	if (!succeeded) PostQuitMessage(0);
+}
+
+// Writes the script stats of the last frame to the debug output, about once per second.
+void report_script_stats(float frame_time)
+{
+	script_report_time += frame_time;
+	if (script_report_time < 1.f) return;
+	script_report_time = 0.f;
+
+	const utl::vector<zone::script::type_stats>& stats{ zone::script::frame_stats() };
+	for (uint32 i{ 0 }; i < stats.size(); ++i)
+	{
+		char line[128];
+		sprintf_s(line, "Script %016llx: %u updates, %.3f ms\n",
+			stats[i].name_hash, stats[i].update_count, stats[i].milliseconds);
+		OutputDebugStringA(line);
+	}
+}
+
+// Waits until it's time to start the next frame.
+void wait_for_next_frame()
+{
+	using namespace std::chrono;
+	const steady_clock::time_point now{ steady_clock::now() };
+	next_frame_time += duration_cast<steady_clock::duration>(duration<float>{ target_frame_time });
+	// NOTE: a frame that ran late doesn't make the next frames run back to back to catch up.
+	if (next_frame_time <= now)
+	{
+		next_frame_time = now;
+		return;
+	}
+
+	// Due times are in 100 ns units. Negative due times are relative to the current time.
+	LARGE_INTEGER due_time{};
+	due_time.QuadPart = -(LONGLONG)(duration_cast<nanoseconds>(next_frame_time - now).count() / 100);
+	if (frame_timer && SetWaitableTimer(frame_timer, &due_time, 0, nullptr, nullptr, FALSE))
+	{
+		WaitForSingleObject(frame_timer, INFINITE);
+	}
+	else
+	{
+		std::this_thread::sleep_until(next_frame_time);
+	}
+}
+
 LRESULT winProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 {
 	switch (msg)
@@ -41,7 +114,9 @@ LRESULT winProc(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
 
 bool engine_initialize()
 {
-	if ((!zone::content::load_game()))return false;
+	if (!jobs::initialize()) return false;
+	if (!platform::initializeAsyncIO()) return false;
+	if (!zone::content::load_game_async("game.bin", nullptr, &on_game_loaded, nullptr)) return false;
 
 	platform::WindowInitInfo info
 	{
@@ -51,18 +126,57 @@ bool engine_initialize()
 	gameWindow.window = platform::createWindow(&info);
 	if (!gameWindow.window.isValid()) return false;
 
+	// NOTE: high-resolution timers need Windows 10 1803. Older versions get a regular one.
+	frame_timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	if (!frame_timer) frame_timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+
+	last_frame_time = std::chrono::steady_clock::now();
+	next_frame_time = last_frame_time;
 	return true;
 }
 
 void engine_update()
 {
-	zone::script::update(10.f);
-	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	const std::chrono::steady_clock::time_point now{ std::chrono::steady_clock::now() };
+	float frame_time{ std::chrono::duration<float>(now - last_frame_time).count() };
+	last_frame_time = now;
+	// NOTE: don't try to catch up after a long stall (breakpoint, window drag, ...).
+	frame_time = frame_time > max_frame_time ? max_frame_time : frame_time;
+
+	zone::content::update_loading(load_budget_us);
+
+	step_accumulator += frame_time;
+	while (step_accumulator >= simulation_step)
+	{
+		zone::transform::begin_simulation_step();
+		zone::script::update_tasks(simulation_step);
+		zone::script::update(simulation_step, zone::script::tick_group::pre_physics);
+		zone::script::update(simulation_step, zone::script::tick_group::post_physics);
+		zone::script::update(simulation_step, zone::script::tick_group::late);
+		step_accumulator -= simulation_step;
+	}
+
+	zone::script::dispatch_events();
+	if (zone::script::is_profiling_enabled())
+	{
+		zone::script::end_frame();
+		report_script_stats(frame_time);
+	}
+
+	zone::transform::update_world_matrices(step_accumulator / simulation_step);
+	zone::bounds::update();
+	zone::transform::publish_snapshot();
+	zone::transform::clear_changes();
+	wait_for_next_frame();
 }
 
 void engine_shutdown()
 {
 	platform::removeWindow(gameWindow.window.getID());
 	zone::content::unload_game();
+	platform::shutdownAsyncIO();
+	jobs::shutdown();
+	if (frame_timer) CloseHandle(frame_timer);
+	frame_timer = nullptr;
 }
 #endif // !defined(SHIPPING)
\ No newline at end of file
@@ -0,0 +1,176 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#include "JobSystem.h"
+#include <thread>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+
+namespace zone::jobs {
+namespace {
+
+struct job_batch
+{
+	job_func				func{ nullptr };
+	void*					context{ nullptr };
+	uint32					count{ 0 };
+	uint32					batch_size{ 0 };
+	uint32					num_batches{ 0 };
+	std::atomic<uint32>		next_batch{ 0 };
+	std::atomic<uint32>		remaining{ 0 };
+};
+
+std::unique_ptr<std::thread[]>	workers;
+uint32							num_workers{ 0 };
+
+std::mutex						job_mutex;
+std::condition_variable			job_cv;
+std::condition_variable			done_cv;
+std::mutex						dispatch_mutex;
+job_batch						current_job;
+uint64							job_generation{ 0 };
+uint32							active_workers{ 0 };
+bool							is_shutting_down{ false };
+
+thread_local bool				is_worker_thread{ false };
+
+void run_batches(job_batch& job)
+{
+	while (true)
+	{
+		const uint32 batch{ job.next_batch.fetch_add(1, std::memory_order_relaxed) };
+		if (batch >= job.num_batches) break;
+
+		const uint32 begin{ batch * job.batch_size };
+		const uint32 end{ std::min(begin + job.batch_size, job.count) };
+		job.func(begin, end, job.context);
+
+		if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			std::lock_guard lock{ job_mutex };
+			done_cv.notify_all();
+		}
+	}
+}
+
+void worker_loop()
+{
+	is_worker_thread = true;
+	uint64 seen_generation{ 0 };
+
+	while (true)
+	{
+		{
+			std::unique_lock lock{ job_mutex };
+			job_cv.wait(lock, [&] { return is_shutting_down || job_generation != seen_generation; });
+			if (is_shutting_down) return;
+			seen_generation = job_generation;
+			++active_workers;
+		}
+
+		run_batches(current_job);
+
+		{
+			std::lock_guard lock{ job_mutex };
+			--active_workers;
+			done_cv.notify_all();
+		}
+	}
+}
+
+} // anonymous namespace
+
+bool initialize(uint32 worker_threads)
+{
+	assert(!workers);
+	if (workers) return true;
+
+	if (!worker_threads)
+	{
+		const uint32 hardware_threads{ std::thread::hardware_concurrency() };
+		worker_threads = hardware_threads > 1 ? hardware_threads - 1 : 0;
+	}
+
+	is_shutting_down = false;
+	num_workers = worker_threads;
+	if (!num_workers) return true;
+
+	workers = std::make_unique<std::thread[]>(num_workers);
+	for (uint32 i{ 0 }; i < num_workers; ++i)
+	{
+		workers[i] = std::thread{ worker_loop };
+	}
+
+	return true;
+}
+
+void shutdown()
+{
+	{
+		std::lock_guard lock{ job_mutex };
+		is_shutting_down = true;
+	}
+	job_cv.notify_all();
+
+	for (uint32 i{ 0 }; i < num_workers; ++i)
+	{
+		if (workers[i].joinable()) workers[i].join();
+	}
+
+	workers.reset();
+	num_workers = 0;
+}
+
+uint32 worker_count()
+{
+	return num_workers;
+}
+
+void parallel_for(uint32 count, uint32 min_batch_size, job_func func, void* context)
+{
+	assert(func);
+	if (!count) return;
+
+	min_batch_size = std::max(min_batch_size, 1u);
+	const uint32 num_threads{ num_workers + 1 };
+	uint32 batch_size{ (count + num_threads - 1) / num_threads };
+	batch_size = std::max(batch_size, min_batch_size);
+
+	if (!num_workers || is_worker_thread || batch_size >= count)
+	{
+		func(0, count, context);
+		return;
+	}
+
+	std::unique_lock dispatch_lock{ dispatch_mutex, std::try_to_lock };
+	if (!dispatch_lock.owns_lock())
+	{
+		func(0, count, context);
+		return;
+	}
+
+	{
+		std::unique_lock lock{ job_mutex };
+		// NOTE: a worker that woke up late for the previous job may still be looking
+		//		 at the batch counters.
+		done_cv.wait(lock, [] { return active_workers == 0; });
+		current_job.func = func;
+		current_job.context = context;
+		current_job.count = count;
+		current_job.batch_size = batch_size;
+		current_job.num_batches = (count + batch_size - 1) / batch_size;
+		current_job.next_batch.store(0, std::memory_order_relaxed);
+		current_job.remaining.store(current_job.num_batches, std::memory_order_relaxed);
+		++job_generation;
+	}
+	job_cv.notify_all();
+
+	run_batches(current_job);
+
+	// NOTE: we also wait for the workers to leave run_batches(), so that the next call
+	//		 can safely reset the batch counters.
+	std::unique_lock lock{ job_mutex };
+	done_cv.wait(lock, [] { return current_job.remaining.load(std::memory_order_acquire) == 0 && active_workers == 0; });
+}
+
+}
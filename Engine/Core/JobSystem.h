@@ -0,0 +1,23 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "CommonHeaders.h"
+
+namespace zone::jobs {
+
+// Processes the items in [begin, end). 'context' is the pointer passed to parallel_for().
+using job_func = void(*)(uint32 begin, uint32 end, void* context);
+
+// Starts the worker threads. When 'worker_threads' is 0, one worker per hardware thread
+// (minus the calling thread) is created.
+bool initialize(uint32 worker_threads = 0);
+void shutdown();
+uint32 worker_count();
+
+// Splits [0, count) into batches of at least 'min_batch_size' items and runs them on the
+// worker threads and the calling thread. Returns when all batches are finished.
+// NOTE: falls back to a serial call when the job system isn't running, when called from
+//       a worker thread or while another parallel_for() is in flight.
+void parallel_for(uint32 count, uint32 min_batch_size, job_func func, void* context);
+
+}
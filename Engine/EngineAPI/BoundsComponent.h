@@ -0,0 +1,73 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#pragma once
+#include "..\Components\ComponentsCommon.h"
+
+namespace zone {
+namespace game_entity { class entity; }
+
+namespace bounds {
+
+DEFINE_TYPED_ID(bounds_id);
+
+struct aabb
+{
+	math::Vec3F min;
+	math::Vec3F max;
+};
+
+struct sphere
+{
+	math::Vec3F center;
+	float radius;
+};
+
+// 'direction' doesn't need to be normalized, hit distances are in units of its length.
+struct ray
+{
+	math::Vec3F origin;
+	math::Vec3F direction;
+	float max_distance;
+};
+
+// Each plane is (normal, d) with the normal pointing inside: dot(normal, p) + d >= 0.
+struct frustum
+{
+	math::Vec4F planes[6];
+};
+
+class component final
+{
+public:
+	constexpr explicit component(bounds_id id) : _id{ id } {};
+	constexpr component() : _id{ id::invalid_id } {};
+	constexpr bounds_id get_id() const { return _id; }
+	constexpr bool is_valid() const { return id::is_valid(_id); }
+
+	game_entity::entity entity() const;
+	// World-space box as of the last bounds update.
+	aabb world_bounds() const;
+	void set_local_bounds(const math::Vec3F& center, const math::Vec3F& extents);
+private:
+	bounds_id _id;
+
+};
+
+struct ray_hit
+{
+	component bounds{};
+	float distance{ 0.f };
+};
+
+// Batched queries: 'count' queries are run in one call. The bounds found by query 'i' are
+// results[offsets[i]] to results[offsets[i + 1]] (exclusive), so 'offsets' gets count + 1
+// entries. 'results' and 'offsets' are cleared first.
+void query_aabbs(const aabb *const boxes, uint32 count, utl::vector<component>& results, utl::vector<uint32>& offsets);
+void query_spheres(const sphere *const spheres, uint32 count, utl::vector<component>& results, utl::vector<uint32>& offsets);
+void query_frustums(const frustum *const frustums, uint32 count, utl::vector<component>& results, utl::vector<uint32>& offsets);
+// Finds the closest hit of each ray. 'hits[i].bounds' is invalid when ray 'i' hit nothing.
+void raycast(const ray *const rays, uint32 count, ray_hit *const hits);
+
+} // namespace bounds
+} // namespace zone
@@ -5,6 +5,7 @@
 #include "..\Components\ComponentsCommon.h"
 #include "TransformComponent.h"
 #include "ScriptComponent.h"
+#include "BoundsComponent.h"
 
 
 
@@ -22,6 +23,7 @@ public:
 
 	transform::component transform() const;
 	script::component script() const;
+	bounds::component bounds() const;
 private:
 	entity_id _id;
 };
@@ -30,9 +32,35 @@ private:
 
 namespace script 
 {
+// Scripts are updated by tick group, in this order, every simulation step.
+// NOTE: the engine has no physics yet, so pre_physics and post_physics run back to back.
+//		 A physics step goes between them.
+struct tick_group
+{
+	enum group : uint8
+	{
+		pre_physics,
+		post_physics,
+		// After all other scripts, e.g. for cameras that follow other entities.
+		late,
+
+		count
+	};
+};
+
 class entity_script : public game_entity::entity
 {
 public:
+	// NOTE: a script type can set this to true in its own class to have its scripts updated
+	//		 on the worker threads. Parallel-safe scripts may only change their own state
+	//		 and their own entity's transform. They must not create or remove entities.
+	static constexpr bool parallel_safe{ false };
+	// The tick group of a script type. Can be changed the same way as parallel_safe.
+	static constexpr tick_group::group update_group{ tick_group::pre_physics };
+	// A script type that doesn't need to run every step can tick every 'tick_interval' steps
+	// by default. Its update() then gets the time since its last update.
+	static constexpr uint32 tick_interval{ 1 };
+
 	virtual ~entity_script() = default;
 	virtual void begin_play() {};
 	virtual void update(float) {};
@@ -43,22 +71,113 @@ private:
 };
 
 namespace detail {
-using script_ptr = std::unique_ptr<entity_script>;
-using script_creator = script_ptr(*)(game_entity::entity entity);
-using string_hash = std::hash<std::string>;
+// Entry points of one script type, created by REGISTER_SCRIPT. The engine keeps the scripts
+// of each type together in their own pool and manages them only through these functions,
+// so a whole pool is updated with one indirect call instead of one virtual call per script.
+struct script_type_info
+{
+	// hash_script_name() of the name given to REGISTER_SCRIPT.
+	uint64 name_hash;
+	uint32 size;
+	uint32 alignment;
+	bool parallel_safe;
+	tick_group::group group;
+	uint32 tick_interval;
+	// Constructs a script for 'entity' in the memory at 'at'.
+	void (*construct)(void* at, game_entity::entity entity);
+	// Move-constructs the script at 'to' from the one at 'from', then destroys 'from'.
+	void (*relocate)(void* to, void* from);
+	void (*destroy)(void* at);
+	// Calls begin_play() of 'count' contiguous scripts starting at 'scripts'.
+	void (*begin_play_all)(void* scripts, uint32 count);
+	// Updates 'count' contiguous scripts starting at 'scripts'.
+	void (*update_all)(void* scripts, uint32 count, float dt);
+};
+
+using script_creator = const script_type_info*;
+
+// 64-bit FNV-1a hash of a script name. This is the key of the script type in the registry.
+// REGISTER_SCRIPT evaluates it at compile time.
+constexpr uint64 hash_script_name(const char* name, uint64 length)
+{
+	return utl::hash_fnv1a(name, length);
+}
+
+constexpr uint64 hash_script_name(const char* name)
+{
+	return utl::hash_fnv1a(name);
+}
 
-uint8 register_script(size_t, script_creator);
+uint8 register_script(uint64, script_creator);
 
 #ifdef USE_WITH_EDITOR
 extern "C" __declspec(dllexport)
 #endif // USE_WITH_EDITOR
-script_creator get_script_creator(size_t tag);
+script_creator get_script_creator(uint64 tag);
 
 template<class script_class>
-script_ptr create_script(game_entity::entity entity)
+void construct_script(void* at, game_entity::entity entity)
 {
 	assert(entity.is_valid());
-	return std::make_unique<script_class>(entity);
+	new (at) script_class{ entity };
+}
+
+template<class script_class>
+void relocate_script(void* to, void* from)
+{
+	script_class *const script{ (script_class*)from };
+	new (to) script_class{ std::move(*script) };
+	script->~script_class();
+}
+
+template<class script_class>
+void destroy_script(void* at)
+{
+	((script_class*)at)->~script_class();
+}
+
+template<class script_class>
+void begin_play_scripts(void* scripts, uint32 count)
+{
+	script_class *const first{ (script_class*)scripts };
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		first[i].script_class::begin_play();
+	}
+}
+
+template<class script_class>
+void update_scripts(void* scripts, uint32 count, float dt)
+{
+	script_class *const first{ (script_class*)scripts };
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		// NOTE: the qualified call isn't virtual, so the compiler can inline it.
+		first[i].script_class::update(dt);
+	}
+}
+
+template<class script_class, uint64 name_hash>
+script_creator get_script_type()
+{
+	static_assert(std::is_base_of_v<entity_script, script_class>);
+	static_assert(std::is_move_constructible_v<script_class>, "Scripts are moved around in their pool and must be move constructible.");
+	static_assert(script_class::tick_interval > 0);
+	static const script_type_info info
+	{
+		name_hash,
+		(uint32)sizeof(script_class),
+		(uint32)alignof(script_class),
+		script_class::parallel_safe,
+		script_class::update_group,
+		script_class::tick_interval,
+		&construct_script<script_class>,
+		&relocate_script<script_class>,
+		&destroy_script<script_class>,
+		&begin_play_scripts<script_class>,
+		&update_scripts<script_class>,
+	};
+	return &info;
 }
 
 #ifdef USE_WITH_EDITOR
@@ -66,10 +185,12 @@ uint8 add_script_name(const char* name);
 
 #define REGISTER_SCRIPT(TYPE)															\
 		namespace {				                                                        \
+		constexpr uint64 _hash_##TYPE                                                   \
+		{ zone::script::detail::hash_script_name(#TYPE) };								\
 		const uint8 _reg_##TYPE                                                         \
 		{ zone::script::detail::register_script(                                        \
-			zone::script::detail::string_hash()(#TYPE),									\
-			&zone::script::detail::create_script<TYPE>) };								\
+			_hash_##TYPE,																\
+			zone::script::detail::get_script_type<TYPE, _hash_##TYPE>()) };			\
 		const uint8 _name_##TYPE                                                        \
 		{ zone::script::detail::add_script_name(#TYPE) };								\
 		}																				
@@ -77,10 +198,12 @@ uint8 add_script_name(const char* name);
 #else
 #define REGISTER_SCRIPT(TYPE)															\
 		namespace {				                                                        \
+		constexpr uint64 _hash_##TYPE                                                   \
+		{ zone::script::detail::hash_script_name(#TYPE) };								\
 		const uint8 _reg_##TYPE                                                         \
 		{ zone::script::detail::register_script(                                        \
-			zone::script::detail::string_hash()(#TYPE),									\
-			&zone::script::detail::create_script<TYPE>) };								\
+			_hash_##TYPE,																\
+			zone::script::detail::get_script_type<TYPE, _hash_##TYPE>()) };			\
 		}
 
 #endif // USE_WITH_EDITOR
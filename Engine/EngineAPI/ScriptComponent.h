@@ -16,6 +16,10 @@ public:
 	constexpr script_id get_id() const { return _id; }
 	constexpr bool is_valid() const { return id::is_valid(_id); }
 
+	// Updates the script every 'interval' simulation steps instead of the default interval
+	// of its type. 1 means every step. While scripts are updated, the change is applied after
+	// the update of the current tick group.
+	void set_tick_interval(uint32 interval) const;
 private:
 	script_id _id;
 
@@ -0,0 +1,61 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#pragma once
+#include "GameEntity.h"
+
+namespace zone::script {
+namespace detail {
+// Delivers 'count' events of one type to scripts of one type. 'scripts[i]' gets 'events[i]'.
+using event_handler = void(*)(void *const* scripts, const void *const* events, uint32 count);
+
+uint32 new_event_type_id();
+// Reserves room for an event in the calling thread's event buffer and returns where to copy it.
+void* add_event(uint32 event_type, uint32 size, game_entity::entity_id target);
+uint8 register_event_handler(uint64 script_name_hash, uint32 event_type, event_handler handler);
+
+template<class event_class>
+uint32 event_type_id()
+{
+	static const uint32 id{ new_event_type_id() };
+	return id;
+}
+
+template<class script_class, class event_class>
+void handle_events(void *const* scripts, const void *const* events, uint32 count)
+{
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		((script_class*)scripts[i])->script_class::on_event(*(const event_class*)events[i]);
+	}
+}
+} // namespace detail
+
+// Sends 'event' to the script of 'target'. Events are copied into a buffer of the calling
+// thread and delivered once per frame, grouped by event type and by receiving script type.
+// The script type handles it if it has an on_event(const event_class&) function that was
+// registered with REGISTER_EVENT_HANDLER. Other events are dropped.
+// NOTE: events sent while events are delivered arrive in the next frame.
+template<class event_class>
+void send_event(game_entity::entity target, const event_class& event)
+{
+	static_assert(std::is_trivially_copyable_v<event_class>, "Events are copied around as bytes and must be trivially copyable.");
+	static_assert(alignof(event_class) <= 16);
+	assert(target.is_valid());
+	void *const at{ detail::add_event(detail::event_type_id<event_class>(), (uint32)sizeof(event_class), target.get_id()) };
+	memcpy(at, &event, sizeof(event_class));
+}
+
+// NOTE: the script pointers of a batch are looked up before it's delivered. Scripts that
+//		 the handler removes are destroyed after the whole batch, so the remaining pointers
+//		 of the batch stay valid.
+#define REGISTER_EVENT_HANDLER(SCRIPT, EVENT)											\
+		namespace {				                                                        \
+		const uint8 _event_##SCRIPT##_##EVENT                                           \
+		{ zone::script::detail::register_event_handler(                                 \
+			zone::script::detail::hash_script_name(#SCRIPT),							\
+			zone::script::detail::event_type_id<EVENT>(),								\
+			&zone::script::detail::handle_events<SCRIPT, EVENT>) };						\
+		}
+
+} // namespace zone::script
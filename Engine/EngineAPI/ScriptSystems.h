@@ -0,0 +1,65 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#pragma once
+#include "GameEntity.h"
+
+namespace zone::script {
+
+// Transform data a script system works on.
+struct system_access
+{
+	enum : uint8
+	{
+		none = 0x00,
+		positions = 0x01,
+		rotations = 0x02,
+
+		all = positions | rotations
+	};
+};
+
+// One batch of scripts of the same type, handed to a script system. All arrays have 'count'
+// items and item 'i' of each array belongs to the same entity. 'positions' and 'rotations'
+// hold the transforms of the entities, or are null when the system didn't ask for them.
+// The values the system changes are written back to the transforms when it returns.
+template<class script_class>
+struct system_batch
+{
+	script_class*							scripts;
+	const game_entity::entity_id*			entities;
+	math::Vec3F*							positions;
+	math::Vec4F*							rotations;
+	uint32									count;
+};
+
+namespace detail {
+using script_system = void(*)(void* scripts, const game_entity::entity_id* entities,
+	math::Vec3F* positions, math::Vec4F* rotations, uint32 count, float dt);
+
+uint8 register_script_system(uint64 script_name_hash, script_system system, uint8 access);
+
+template<class script_class, void (*system)(const system_batch<script_class>&, float)>
+void run_script_system(void* scripts, const game_entity::entity_id* entities,
+	math::Vec3F* positions, math::Vec4F* rotations, uint32 count, float dt)
+{
+	system(system_batch<script_class>{ (script_class*)scripts, entities, positions, rotations, count }, dt);
+}
+} // namespace detail
+
+// Replaces the per-script update() of TYPE with FUNC, a function that updates contiguous
+// batches of TYPE scripts:
+//		void FUNC(const zone::script::system_batch<TYPE>& batch, float dt);
+// ACCESS is a combination of system_access flags for the transform data the system needs.
+// The scripts of a type are stored in large blocks, so there are only a few batches per
+// update. begin_play(), tick groups and tick intervals work the same as for scripts.
+#define REGISTER_SCRIPT_SYSTEM(TYPE, FUNC, ACCESS)										\
+		namespace {				                                                        \
+		const uint8 _system_##TYPE                                                      \
+		{ zone::script::detail::register_script_system(                                 \
+			zone::script::detail::hash_script_name(#TYPE),								\
+			&zone::script::detail::run_script_system<TYPE, &FUNC>,						\
+			ACCESS) };																	\
+		}
+
+} // namespace zone::script
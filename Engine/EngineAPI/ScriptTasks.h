@@ -0,0 +1,123 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#pragma once
+#include "GameEntity.h"
+#include <coroutine>
+
+namespace zone::script {
+namespace detail {
+void* allocate_task_frame(uint64 size);
+void free_task_frame(void* frame, uint64 size);
+void add_task_timer(std::coroutine_handle<> handle, game_entity::entity_id owner, float seconds);
+void* get_entity_script(game_entity::entity_id id);
+
+uint32 create_trigger();
+void remove_trigger(uint32 id);
+void fire_trigger(uint32 id);
+void reset_trigger(uint32 id);
+bool is_trigger_fired(uint32 id);
+void add_trigger_waiter(uint32 id, std::coroutine_handle<> handle, game_entity::entity_id owner);
+} // namespace detail
+
+// Return type of latent script actions, which are coroutines that can wait with co_await.
+// A task runs right away until its first co_await. After that, the engine owns it and
+// resumes it when what it waits for has happened. Waiting tasks cost nothing per frame.
+// A task whose first parameter is an entity (or the script, for member functions) belongs
+// to that entity and is dropped when the entity is removed.
+// NOTE: scripts move in memory when other scripts are removed. So, after a co_await, get
+//		 the script again with get_script() instead of using 'this' or a saved pointer.
+class task
+{
+public:
+	struct promise_type
+	{
+		promise_type() = default;
+
+		template<typename... params>
+		promise_type(const game_entity::entity& owner, params&&...) : owner{ owner.get_id() } {}
+
+		task get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { assert(false); }
+
+		// NOTE: the coroutine frames are pooled by the engine.
+		static void* operator new(size_t size) { return detail::allocate_task_frame(size); }
+		static void operator delete(void* frame, size_t size) { detail::free_task_frame(frame, size); }
+
+		game_entity::entity_id owner{ id::invalid_id };
+	};
+};
+
+// Suspends the task for 'seconds' of simulation time.
+class wait_seconds
+{
+public:
+	constexpr explicit wait_seconds(float seconds) : _seconds{ seconds } {}
+
+	bool await_ready() const { return _seconds <= 0.f; }
+	void await_suspend(std::coroutine_handle<task::promise_type> handle) const
+	{
+		detail::add_task_timer(handle, handle.promise().owner, _seconds);
+	}
+	void await_resume() const {}
+private:
+	float _seconds;
+};
+
+// A flag that tasks can wait for, e.g. for the end of an animation or of an asset load.
+// Tasks waiting for it are resumed in the next task update after fire() is called. A fired
+// trigger lets tasks through until it's reset.
+class trigger
+{
+public:
+	trigger() : _id{ detail::create_trigger() } {}
+	~trigger() { if (_id != uint32_invalid_id) detail::remove_trigger(_id); }
+	trigger(trigger&& other) noexcept : _id{ other._id } { other._id = uint32_invalid_id; }
+	trigger& operator=(trigger&& other) noexcept
+	{
+		if (this != &other)
+		{
+			if (_id != uint32_invalid_id) detail::remove_trigger(_id);
+			_id = other._id;
+			other._id = uint32_invalid_id;
+		}
+		return *this;
+	}
+	DISABLE_COPY(trigger);
+
+	void fire() const { detail::fire_trigger(_id); }
+	void reset() const { detail::reset_trigger(_id); }
+	bool is_fired() const { return detail::is_trigger_fired(_id); }
+
+	class awaiter
+	{
+	public:
+		constexpr explicit awaiter(uint32 id) : _id{ id } {}
+
+		bool await_ready() const { return detail::is_trigger_fired(_id); }
+		void await_suspend(std::coroutine_handle<task::promise_type> handle) const
+		{
+			detail::add_trigger_waiter(_id, handle, handle.promise().owner);
+		}
+		void await_resume() const {}
+	private:
+		uint32 _id;
+	};
+
+	awaiter operator co_await() const { return awaiter{ _id }; }
+private:
+	uint32 _id;
+};
+
+// Returns the script of 'entity'. The pointer is only valid until the next co_await.
+template<class script_class>
+script_class* get_script(game_entity::entity entity)
+{
+	static_assert(std::is_base_of_v<entity_script, script_class>);
+	return (script_class*)detail::get_entity_script(entity.get_id());
+}
+
+} // namespace zone::script
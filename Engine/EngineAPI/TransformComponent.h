@@ -3,6 +3,7 @@
 
 #pragma once
 #include "..\Components\ComponentsCommon.h"
+#include <span>
 
 namespace zone::transform {
 
@@ -19,9 +20,27 @@ public:
 	math::Vec3F position() const;
 	math::Vec4F rotation() const;
 	math::Vec3F scale() const;
+	math::Mat3x4F world_matrix() const;
+	bool is_static() const;
+
+	// NOTE: only dynamic transforms can be moved.
+	void set_position(const math::Vec3F& position);
+	void set_rotation(const math::Vec4F& rotation);
+	void set_scale(const math::Vec3F& scale);
 private:
 	transform_id _id;
 
 };
 
+// Batched writes: 'values[i]' is written to the transform 'ids[i]' and the transform is
+// marked as changed. Meant for systems that move many entities per frame, e.g. physics
+// and animation write-back. Must be called from the simulation thread.
+void set_positions(std::span<const transform_id> ids, std::span<const math::Vec3F> values);
+void set_rotations(std::span<const transform_id> ids, std::span<const math::Vec4F> values);
+void set_scales(std::span<const transform_id> ids, std::span<const math::Vec3F> values);
+
+// Batched reads: the value of the transform 'ids[i]' is written to 'values[i]'.
+void get_positions(std::span<const transform_id> ids, std::span<math::Vec3F> values);
+void get_rotations(std::span<const transform_id> ids, std::span<math::Vec4F> values);
+
 }
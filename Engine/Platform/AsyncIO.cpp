@@ -0,0 +1,606 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#include "AsyncIO.h"
+#include "PlatformTypes.h"
+#include <thread>
+#include <condition_variable>
+
+#ifndef _WIN64
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // !_WIN64
+
+// NOTE: io_uring is only on Linux. Everywhere else the thread pool backend is used.
+#if defined(__linux__) && !defined(_WIN64)
+#define USE_IO_URING 1
+#else
+#define USE_IO_URING 0
+#endif
+
+#if USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif // USE_IO_URING
+
+namespace zone::platform {
+namespace {
+
+#ifdef _WIN64
+using NativeFile = HANDLE;
+#else
+using NativeFile = int32;
+#endif // _WIN64
+
+	AsyncIOBackend							backend{ AsyncIOBackend::none };
+	bool									isShuttingDown{ false };
+
+	utl::vector<NativeFile>					files;
+	utl::vector<uint32>						freeFiles;
+	std::mutex								fileMutex;
+
+	// Thread pool backend
+	constexpr uint32						defaultThreadCount{ 8 };
+	std::unique_ptr<std::thread[]>			poolThreads;
+	uint32									poolThreadCount{ 0 };
+	utl::deque<AsyncRead>					poolQueue;
+	std::mutex								poolMutex;
+	std::condition_variable					poolCV;
+
+NativeFile nativeFile(uint32 file)
+{
+	std::lock_guard lock{ fileMutex };
+	assert(file < files.size());
+	return files[file];
+}
+
+#ifdef _WIN64
+// NOTE: reads on a handle that wasn't opened for overlapped I/O are serialized by the OS,
+//		 even with explicit offsets. So, files are opened with FILE_FLAG_OVERLAPPED and each
+//		 thread waits for its own reads on its own event.
+struct ThreadEvent
+{
+	HANDLE handle{ CreateEventA(nullptr, FALSE, FALSE, nullptr) };
+	~ThreadEvent() { CloseHandle(handle); }
+};
+
+bool readAt(NativeFile file, uint64 offset, uint8* buffer, uint32 size, uint32& bytesRead)
+{
+	thread_local ThreadEvent event{};
+	OVERLAPPED overlapped{};
+	overlapped.Offset = (DWORD)offset;
+	overlapped.OffsetHigh = (DWORD)(offset >> 32);
+	overlapped.hEvent = event.handle;
+
+	bytesRead = 0;
+	if (!ReadFile(file, buffer, size, nullptr, &overlapped) && GetLastError() != ERROR_IO_PENDING)
+	{
+		return GetLastError() == ERROR_HANDLE_EOF;
+	}
+
+	DWORD read{ 0 };
+	if (!GetOverlappedResult(file, &overlapped, &read, TRUE)) return GetLastError() == ERROR_HANDLE_EOF;
+	bytesRead = read;
+	return true;
+}
+#else
+bool readAt(NativeFile file, uint64 offset, uint8* buffer, uint32 size, uint32& bytesRead)
+{
+	bytesRead = 0;
+	while (bytesRead < size)
+	{
+		const ssize_t result{ pread(file, buffer + bytesRead, size - bytesRead, (off_t)(offset + bytesRead)) };
+		if (result < 0)
+		{
+			if (errno == EINTR) continue;
+			return false;
+		}
+		if (!result) break; // end of file
+		bytesRead += (uint32)result;
+	}
+	return true;
+}
+#endif // _WIN64
+
+void runRead(const AsyncRead& read)
+{
+	uint32 bytesRead{ 0 };
+	const bool succeeded{ readAt(nativeFile(read.file), read.offset, read.buffer, read.size, bytesRead) };
+	if (read.callback) read.callback(read.context, succeeded, bytesRead);
+}
+
+void poolWorker()
+{
+	for (;;)
+	{
+		AsyncRead read{};
+		{
+			std::unique_lock lock{ poolMutex };
+			poolCV.wait(lock, [] { return isShuttingDown || !poolQueue.empty(); });
+			// NOTE: the reads that are still queued at shutdown are finished first.
+			if (poolQueue.empty()) return;
+			read = poolQueue.front();
+			poolQueue.pop_front();
+		}
+
+		runRead(read);
+	}
+}
+
+#if USE_IO_URING
+// io_uring backend. Reads go into the submission ring and the kernel runs them concurrently.
+// One thread waits for the completions and calls the callbacks.
+struct Ring
+{
+	int32									fd{ -1 };
+	uint8*									sqRing{ nullptr };
+	uint8*									cqRing{ nullptr };
+	uint64									sqRingSize{ 0 };
+	uint64									cqRingSize{ 0 };
+	io_uring_sqe*							sqes{ nullptr };
+	uint64									sqesSize{ 0 };
+	uint32*									sqHead{ nullptr };
+	uint32*									sqTail{ nullptr };
+	uint32*									sqMask{ nullptr };
+	uint32*									sqArray{ nullptr };
+	uint32*									cqHead{ nullptr };
+	uint32*									cqTail{ nullptr };
+	uint32*									cqMask{ nullptr };
+	io_uring_cqe*							cqes{ nullptr };
+	uint32									sqEntries{ 0 };
+	uint32									cqEntries{ 0 };
+};
+
+	constexpr uint32						ringEntries{ 256 };
+	constexpr uint64						wakeUpData{ ~0ull };
+	Ring									ring{};
+	std::thread								completionThread;
+	// NOTE: the reads in flight are kept here, the index is the user data of the request.
+	//		 A deque doesn't move its items, so the completion thread can read them safely.
+	utl::deque<AsyncRead>					ringReads;
+	utl::vector<uint32>						freeRingReads;
+	// Reads submitted by callbacks. They're pushed after the completions being handled.
+	utl::deque<AsyncRead>					deferredReads;
+	uint32									readsInFlight{ 0 };
+	bool									hasRegisteredBuffers{ false };
+	std::mutex								ringMutex;
+	std::condition_variable					ringCV;
+
+int32 ioUringSetup(uint32 entries, io_uring_params* params)
+{
+	return (int32)syscall(__NR_io_uring_setup, entries, params);
+}
+
+int32 ioUringEnter(uint32 toSubmit, uint32 minComplete, uint32 flags)
+{
+	return (int32)syscall(__NR_io_uring_enter, ring.fd, toSubmit, minComplete, flags, nullptr, 0);
+}
+
+int32 ioUringRegister(uint32 opcode, const void* args, uint32 count)
+{
+	return (int32)syscall(__NR_io_uring_register, ring.fd, opcode, args, count);
+}
+
+void destroyRing()
+{
+	if (ring.sqes) munmap(ring.sqes, ring.sqesSize);
+	if (ring.cqRing && ring.cqRing != ring.sqRing) munmap(ring.cqRing, ring.cqRingSize);
+	if (ring.sqRing) munmap(ring.sqRing, ring.sqRingSize);
+	if (ring.fd >= 0) close(ring.fd);
+	ring = {};
+}
+
+bool createRing()
+{
+	io_uring_params params{};
+	ring.fd = ioUringSetup(ringEntries, &params);
+	if (ring.fd < 0) return false;
+
+	// NOTE: IORING_OP_READ needs Linux 5.6, which is also when this feature was added.
+	if (!(params.features & IORING_FEAT_RW_CUR_POS))
+	{
+		destroyRing();
+		return false;
+	}
+
+	ring.sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32);
+	ring.cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	const bool singleMap{ (params.features & IORING_FEAT_SINGLE_MMAP) != 0 };
+	if (singleMap)
+	{
+		ring.sqRingSize = ring.cqRingSize = ring.sqRingSize > ring.cqRingSize ? ring.sqRingSize : ring.cqRingSize;
+	}
+
+	void* sq{ mmap(nullptr, ring.sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQ_RING) };
+	if (sq == MAP_FAILED) { destroyRing(); return false; }
+	ring.sqRing = (uint8*)sq;
+
+	void* cq{ singleMap ? sq : mmap(nullptr, ring.cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_CQ_RING) };
+	if (cq == MAP_FAILED) { destroyRing(); return false; }
+	ring.cqRing = (uint8*)cq;
+
+	ring.sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes{ mmap(nullptr, ring.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES) };
+	if (sqes == MAP_FAILED) { destroyRing(); return false; }
+	ring.sqes = (io_uring_sqe*)sqes;
+
+	ring.sqHead = (uint32*)(ring.sqRing + params.sq_off.head);
+	ring.sqTail = (uint32*)(ring.sqRing + params.sq_off.tail);
+	ring.sqMask = (uint32*)(ring.sqRing + params.sq_off.ring_mask);
+	ring.sqArray = (uint32*)(ring.sqRing + params.sq_off.array);
+	ring.cqHead = (uint32*)(ring.cqRing + params.cq_off.head);
+	ring.cqTail = (uint32*)(ring.cqRing + params.cq_off.tail);
+	ring.cqMask = (uint32*)(ring.cqRing + params.cq_off.ring_mask);
+	ring.cqes = (io_uring_cqe*)(ring.cqRing + params.cq_off.cqes);
+	ring.sqEntries = params.sq_entries;
+	ring.cqEntries = params.cq_entries;
+	return true;
+}
+
+// Adds a request to the submission ring. Returns false if the ring is full.
+// NOTE: must be called with ringMutex locked.
+bool pushRequest(uint8 opcode, const AsyncRead* read, uint64 userData)
+{
+	const uint32 tail{ *ring.sqTail };
+	if (tail - __atomic_load_n(ring.sqHead, __ATOMIC_ACQUIRE) == ring.sqEntries) return false;
+
+	const uint32 index{ tail & *ring.sqMask };
+	io_uring_sqe& sqe{ ring.sqes[index] };
+	memset(&sqe, 0, sizeof(sqe));
+	sqe.opcode = opcode;
+	sqe.user_data = userData;
+	if (read)
+	{
+		sqe.fd = nativeFile(read->file);
+		sqe.off = read->offset;
+		sqe.addr = (uint64)read->buffer;
+		sqe.len = read->size;
+		if (opcode == IORING_OP_READ_FIXED) sqe.buf_index = (uint16)read->bufferIndex;
+	}
+
+	ring.sqArray[index] = index;
+	__atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+// Adds a read to the submission ring and counts it as in flight. 'queued' is the number of
+// requests that haven't been passed to the kernel yet.
+// NOTE: must be called with ringMutex locked, while readsInFlight < cqEntries.
+void pushRead(const AsyncRead& read, uint32& queued)
+{
+	assert(readsInFlight < ring.cqEntries);
+	uint32 slot{ uint32_invalid_id };
+	if (freeRingReads.size())
+	{
+		slot = freeRingReads[freeRingReads.size() - 1];
+		freeRingReads.erase(freeRingReads.size() - 1);
+		ringReads[slot] = read;
+	}
+	else
+	{
+		slot = (uint32)ringReads.size();
+		ringReads.emplace_back(read);
+	}
+
+	const bool isFixed{ hasRegisteredBuffers && read.bufferIndex != uint32_invalid_id };
+	const uint8 opcode{ (uint8)(isFixed ? IORING_OP_READ_FIXED : IORING_OP_READ) };
+	if (!pushRequest(opcode, &read, slot))
+	{
+		// The submission ring is full: let the kernel take what's in it.
+		ioUringEnter(queued, 0, 0);
+		queued = 0;
+		[[maybe_unused]] const bool pushed{ pushRequest(opcode, &read, slot) };
+		assert(pushed);
+	}
+
+	++queued;
+	++readsInFlight;
+}
+
+void submitToRing(const AsyncRead* reads, uint32 count)
+{
+	std::unique_lock lock{ ringMutex };
+	// NOTE: callbacks run on the completion thread. It can't wait for room in the completion
+	//		 ring, because it's the only thread that makes room. So, its reads are queued and
+	//		 pushed after the completions it's handling.
+	if (std::this_thread::get_id() == completionThread.get_id())
+	{
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			deferredReads.emplace_back(reads[i]);
+		}
+		return;
+	}
+
+	uint32 queued{ 0 };
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		// NOTE: the completion ring only has room for cqEntries completions. Waiting until
+		//		 enough reads are finished keeps it from overflowing.
+		if (readsInFlight == ring.cqEntries)
+		{
+			if (queued) ioUringEnter(queued, 0, 0);
+			queued = 0;
+			ringCV.wait(lock, [] { return readsInFlight < ring.cqEntries; });
+		}
+
+		pushRead(reads[i], queued);
+	}
+
+	if (queued) ioUringEnter(queued, 0, 0);
+}
+
+// Pushes as many of the reads queued by callbacks as the completion ring has room for.
+// NOTE: must be called with ringMutex locked, on the completion thread.
+void pushDeferredReads()
+{
+	uint32 queued{ 0 };
+	while (!deferredReads.empty() && readsInFlight < ring.cqEntries)
+	{
+		pushRead(deferredReads.front(), queued);
+		deferredReads.pop_front();
+	}
+
+	if (queued) ioUringEnter(queued, 0, 0);
+}
+
+void ringCompletionLoop()
+{
+	for (;;)
+	{
+		if (ioUringEnter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) break;
+
+		uint32 head{ *ring.cqHead };
+		const uint32 tail{ __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE) };
+		for (; head != tail; ++head)
+		{
+			const io_uring_cqe& cqe{ ring.cqes[head & *ring.cqMask] };
+			if (cqe.user_data == wakeUpData) continue;
+
+			AsyncRead read{};
+			{
+				std::lock_guard lock{ ringMutex };
+				read = ringReads[(uint32)cqe.user_data];
+				freeRingReads.emplace_back((uint32)cqe.user_data);
+				--readsInFlight;
+			}
+			ringCV.notify_all();
+
+			if (read.callback) read.callback(read.context, cqe.res >= 0, cqe.res >= 0 ? (uint32)cqe.res : 0);
+		}
+		__atomic_store_n(ring.cqHead, head, __ATOMIC_RELEASE);
+
+		std::lock_guard lock{ ringMutex };
+		// NOTE: the reads that are still queued are pushed even at shutdown. If some are left,
+		//		 the ring is full and the next completions make room for them.
+		pushDeferredReads();
+		if (isShuttingDown && !readsInFlight && deferredReads.empty()) break;
+	}
+}
+
+bool startRing()
+{
+	if (!createRing()) return false;
+	completionThread = std::thread{ ringCompletionLoop };
+	return true;
+}
+
+void stopRing()
+{
+	{
+		std::lock_guard lock{ ringMutex };
+		isShuttingDown = true;
+		// NOTE: the completion thread may be waiting for events, a no-op wakes it up.
+		if (pushRequest(IORING_OP_NOP, nullptr, wakeUpData)) ioUringEnter(1, 0, 0);
+	}
+
+	completionThread.join();
+	destroyRing();
+	ringReads.clear();
+	freeRingReads.clear();
+	assert(deferredReads.empty());
+	hasRegisteredBuffers = false;
+}
+#endif // USE_IO_URING
+
+struct WaitGroup
+{
+	std::mutex								mutex;
+	std::condition_variable					cv;
+	uint32									remaining;
+	bool									succeeded{ true };
+};
+
+struct WaitedRead
+{
+	WaitGroup*								group;
+	uint32									size;
+};
+
+void onWaitedRead(void* context, bool succeeded, uint32 bytesRead)
+{
+	const WaitedRead& read{ *(const WaitedRead*)context };
+	WaitGroup& group{ *read.group };
+	std::lock_guard lock{ group.mutex };
+	if (!succeeded || bytesRead != read.size) group.succeeded = false;
+	if (!--group.remaining) group.cv.notify_all();
+}
+} // anonymous namespace
+
+bool initializeAsyncIO(uint32 threadCount)
+{
+	assert(backend == AsyncIOBackend::none);
+	isShuttingDown = false;
+#if USE_IO_URING
+	if (startRing())
+	{
+		backend = AsyncIOBackend::ioUring;
+		return true;
+	}
+#endif // USE_IO_URING
+
+	poolThreadCount = threadCount ? threadCount : defaultThreadCount;
+	poolThreads.reset(new (std::nothrow) std::thread[poolThreadCount]);
+	if (!poolThreads) return false;
+	for (uint32 i{ 0 }; i < poolThreadCount; ++i)
+	{
+		poolThreads[i] = std::thread{ poolWorker };
+	}
+
+	backend = AsyncIOBackend::threadPool;
+	return true;
+}
+
+void shutdownAsyncIO()
+{
+#if USE_IO_URING
+	if (backend == AsyncIOBackend::ioUring) stopRing();
+#endif // USE_IO_URING
+
+	if (backend == AsyncIOBackend::threadPool)
+	{
+		{
+			std::lock_guard lock{ poolMutex };
+			isShuttingDown = true;
+		}
+		poolCV.notify_all();
+
+		for (uint32 i{ 0 }; i < poolThreadCount; ++i)
+		{
+			if (poolThreads[i].joinable()) poolThreads[i].join();
+		}
+		poolThreads.reset();
+		poolThreadCount = 0;
+	}
+
+	backend = AsyncIOBackend::none;
+}
+
+AsyncIOBackend asyncIOBackend()
+{
+	return backend;
+}
+
+uint32 openAsyncFile(const char* path)
+{
+	assert(path);
+#ifdef _WIN64
+	const NativeFile handle{ CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_FLAG_OVERLAPPED | FILE_FLAG_RANDOM_ACCESS, nullptr) };
+	if (handle == INVALID_HANDLE_VALUE) return uint32_invalid_id;
+#else
+	const NativeFile handle{ open(path, O_RDONLY | O_CLOEXEC) };
+	if (handle < 0) return uint32_invalid_id;
+#endif // _WIN64
+
+	std::lock_guard lock{ fileMutex };
+	if (freeFiles.size())
+	{
+		const uint32 file{ freeFiles[freeFiles.size() - 1] };
+		freeFiles.erase(freeFiles.size() - 1);
+		files[file] = handle;
+		return file;
+	}
+
+	files.emplace_back(handle);
+	return (uint32)files.size() - 1;
+}
+
+void closeAsyncFile(uint32 file)
+{
+	std::lock_guard lock{ fileMutex };
+	assert(file < files.size());
+#ifdef _WIN64
+	CloseHandle(files[file]);
+	files[file] = INVALID_HANDLE_VALUE;
+#else
+	close(files[file]);
+	files[file] = -1;
+#endif // _WIN64
+	freeFiles.emplace_back(file);
+}
+
+bool registerAsyncBuffers(const AsyncBuffer* buffers, uint32 count)
+{
+	assert(buffers || !count);
+#if USE_IO_URING
+	if (backend == AsyncIOBackend::ioUring)
+	{
+		std::lock_guard lock{ ringMutex };
+		assert(!readsInFlight);
+		if (hasRegisteredBuffers) ioUringRegister(IORING_UNREGISTER_BUFFERS, nullptr, 0);
+		hasRegisteredBuffers = false;
+		if (!count) return true;
+
+		utl::vector<iovec> vectors(count);
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			vectors[i].iov_base = buffers[i].data;
+			vectors[i].iov_len = buffers[i].size;
+		}
+
+		// NOTE: if the buffers can't be pinned (e.g. because of the locked memory limit),
+		//		 the reads into them just don't use the fixed buffer path.
+		hasRegisteredBuffers = ioUringRegister(IORING_REGISTER_BUFFERS, vectors.data(), count) == 0;
+		return hasRegisteredBuffers;
+	}
+#endif // USE_IO_URING
+
+	return true;
+}
+
+void submitReads(const AsyncRead* reads, uint32 count)
+{
+	assert(reads || !count);
+#if USE_IO_URING
+	if (backend == AsyncIOBackend::ioUring)
+	{
+		submitToRing(reads, count);
+		return;
+	}
+#endif // USE_IO_URING
+
+	if (backend == AsyncIOBackend::threadPool)
+	{
+		{
+			std::lock_guard lock{ poolMutex };
+			for (uint32 i{ 0 }; i < count; ++i) poolQueue.emplace_back(reads[i]);
+		}
+		poolCV.notify_all();
+		return;
+	}
+
+	// The service isn't running: read on the calling thread.
+	for (uint32 i{ 0 }; i < count; ++i) runRead(reads[i]);
+}
+
+bool readAndWait(const AsyncRead* reads, uint32 count)
+{
+	if (!count) return true;
+#if USE_IO_URING
+	// NOTE: the reads complete on the completion thread, so it can't wait for them.
+	assert(backend != AsyncIOBackend::ioUring || std::this_thread::get_id() != completionThread.get_id());
+#endif // USE_IO_URING
+
+	WaitGroup group{};
+	group.remaining = count;
+	utl::vector<WaitedRead> waited(count);
+	utl::vector<AsyncRead> requests(count);
+	for (uint32 i{ 0 }; i < count; ++i)
+	{
+		waited[i] = { &group, reads[i].size };
+		requests[i] = reads[i];
+		requests[i].callback = onWaitedRead;
+		requests[i].context = &waited[i];
+	}
+
+	submitReads(requests.data(), count);
+
+	std::unique_lock lock{ group.mutex };
+	group.cv.wait(lock, [&group] { return group.remaining == 0; });
+	return group.succeeded;
+}
+
+}
@@ -0,0 +1,62 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "CommonHeaders.h"
+
+namespace zone::platform {
+
+enum class AsyncIOBackend : uint32
+{
+	none,
+	// Reads are submitted to the kernel in batches and complete out of order (Linux).
+	ioUring,
+	// Worker threads do blocking reads at explicit offsets, a few at a time.
+	threadPool,
+};
+
+// Called on an I/O thread when a read has finished. 'bytesRead' can be less than the size
+// of the read at the end of the file.
+// NOTE: callbacks run on the threads that finish the reads, so they must not wait for other
+//		 reads, e.g. with readAndWait(). They can submit new reads with submitReads().
+using AsyncReadCallback = void(*)(void* context, bool succeeded, uint32 bytesRead);
+
+struct AsyncRead
+{
+	uint32					file{ uint32_invalid_id };
+	uint64					offset{ 0 };
+	uint8*					buffer{ nullptr };
+	uint32					size{ 0 };
+	// Index of the registered buffer that holds 'buffer', or uint32_invalid_id.
+	uint32					bufferIndex{ uint32_invalid_id };
+	AsyncReadCallback		callback{ nullptr };
+	void*					context{ nullptr };
+};
+
+struct AsyncBuffer
+{
+	uint8*					data;
+	uint32					size;
+};
+
+// Starts the async I/O service. io_uring is used where the kernel supports it, otherwise
+// 'threadCount' worker threads do the reads (0 picks a default).
+bool initializeAsyncIO(uint32 threadCount = 0);
+void shutdownAsyncIO();
+AsyncIOBackend asyncIOBackend();
+
+// Returns an id for the file at 'path', or uint32_invalid_id.
+uint32 openAsyncFile(const char* path);
+// NOTE: no reads of the file may be in flight.
+void closeAsyncFile(uint32 file);
+
+// Registers buffers that are read into often, e.g. streaming buffers. The io_uring backend
+// pins them once instead of for every read. Replaces the buffers registered before and must
+// be called while no reads are in flight.
+bool registerAsyncBuffers(const AsyncBuffer* buffers, uint32 count);
+
+// Queues 'count' reads. They run concurrently and their callbacks are called in any order.
+void submitReads(const AsyncRead* reads, uint32 count);
+// Runs 'count' reads concurrently and waits for all of them. The callbacks of the reads are
+// not called. Returns false if any read failed or was short.
+bool readAndWait(const AsyncRead* reads, uint32 count);
+}
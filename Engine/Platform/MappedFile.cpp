@@ -0,0 +1,141 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#include "MappedFile.h"
+#include "PlatformTypes.h"
+
+#ifndef _WIN64
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // !_WIN64
+
+namespace zone::platform
+{
+namespace {
+
+uint64 pageSize()
+{
+#ifdef _WIN64
+	SYSTEM_INFO info{};
+	GetSystemInfo(&info);
+	return info.dwPageSize;
+#else
+	return (uint64)sysconf(_SC_PAGESIZE);
+#endif // _WIN64
+}
+
+} // anonymous namespace
+
+#ifdef _WIN64
+
+bool MappedFile::open(const char* path, bool sequential)
+{
+	assert(!isOpen() && path);
+	const DWORD flags{ (DWORD)(sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL) };
+	HANDLE file{ CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, flags, nullptr) };
+	if (file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER file_size{};
+	if (!GetFileSizeEx(file, &file_size) || !file_size.QuadPart)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping{ CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+	const void* view{ mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr };
+	if (!view)
+	{
+		if (mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = file;
+	_mapping = mapping;
+	_data = (const uint8*)view;
+	_size = (uint64)file_size.QuadPart;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (!isOpen()) return;
+	UnmapViewOfFile(_data);
+	CloseHandle(_mapping);
+	CloseHandle(_file);
+	_data = nullptr;
+	_size = 0;
+	_mapping = nullptr;
+	_file = nullptr;
+}
+
+void MappedFile::release(uint64 offset, uint64 size) const
+{
+	assert(isOpen() && offset + size <= _size);
+	const uint64 page{ pageSize() };
+	const uint64 begin{ (offset + page - 1) & ~(page - 1) };
+	const uint64 end{ (offset + size) & ~(page - 1) };
+	if (begin >= end) return;
+
+	// NOTE: unlocking pages that aren't locked removes them from the working set. They're
+	//		 backed by the file, so the OS can drop them without writing anything.
+	VirtualUnlock((void*)(_data + begin), end - begin);
+}
+
+#else
+
+bool MappedFile::open(const char* path, bool sequential)
+{
+	assert(!isOpen() && path);
+	const int fd{ ::open(path, O_RDONLY) };
+	if (fd < 0) return false;
+
+	struct stat info {};
+	if (fstat(fd, &info) || !info.st_size)
+	{
+		::close(fd);
+		return false;
+	}
+
+	void *const view{ mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0) };
+	if (view == MAP_FAILED)
+	{
+		::close(fd);
+		return false;
+	}
+
+	if (sequential) madvise(view, (size_t)info.st_size, MADV_SEQUENTIAL);
+
+	_fd = fd;
+	_data = (const uint8*)view;
+	_size = (uint64)info.st_size;
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (!isOpen()) return;
+	munmap((void*)_data, _size);
+	::close(_fd);
+	_data = nullptr;
+	_size = 0;
+	_fd = -1;
+}
+
+void MappedFile::release(uint64 offset, uint64 size) const
+{
+	assert(isOpen() && offset + size <= _size);
+	const uint64 page{ pageSize() };
+	const uint64 begin{ (offset + page - 1) & ~(page - 1) };
+	const uint64 end{ (offset + size) & ~(page - 1) };
+	if (begin >= end) return;
+
+	// NOTE: the mapping is read-only and private, so the pages are dropped and read from the
+	//		 file again if they're touched later.
+	madvise((void*)(_data + begin), end - begin, MADV_DONTNEED);
+}
+
+#endif // _WIN64
+}
@@ -0,0 +1,40 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "CommonHeaders.h"
+
+namespace zone::platform {
+
+// Read-only view of a whole file mapped into memory. The pages are read from disk by the OS
+// when they're first touched, so nothing is copied up front.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+	DISABLE_COPY_AND_MOVE(MappedFile);
+
+	// Maps the file at 'path'. 'sequential' tells the OS that the file is read from front to
+	// back, so it can read ahead.
+	bool open(const char* path, bool sequential = true);
+	void close();
+
+	// Tells the OS that [offset, offset + size) won't be read again, so it can drop those pages
+	// from memory. Only whole pages inside the range are released.
+	void release(uint64 offset, uint64 size) const;
+
+	constexpr const uint8* data() const { return _data; }
+	constexpr uint64 size() const { return _size; }
+	constexpr bool isOpen() const { return _data != nullptr; }
+private:
+	const uint8*	_data{ nullptr };
+	uint64			_size{ 0 };
+#ifdef _WIN64
+	void*			_file{ nullptr };
+	void*			_mapping{ nullptr };
+#else
+	int32			_fd{ -1 };
+#endif // _WIN64
+};
+
+}
@@ -0,0 +1,176 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "CommonHeaders.h"
+
+namespace zone::utl
+{
+
+// NOTE: a small LZ77 codec in the style of LZ4. The compressed data is a list of sequences:
+//			token			high 4 bits: literal count, low 4 bits: match length - lz_min_match
+//			[length bytes]	more literal count when it's 15: 255 while there's more, then the rest
+//			literals
+//			offset			uint16, distance back to the match (not in the last sequence)
+//			[length bytes]	more match length when it's 15, same as for the literals
+//		 The last sequence only has literals. Decompression doesn't allocate and checks every
+//		 read and write, so broken data can't write outside of the output buffer.
+constexpr uint32 lz_min_match{ 4 };
+constexpr uint32 lz_max_offset{ 0xffff };
+constexpr uint32 lz_hash_bits{ 14 };
+
+// Largest compressed size of 'size' bytes, for data that doesn't compress at all.
+constexpr uint64 lz_compress_bound(uint64 size)
+{
+	return size + size / 255 + 16;
+}
+
+namespace detail {
+inline uint32 lz_read32(const uint8* at)
+{
+	uint32 value;
+	memcpy(&value, at, sizeof(value));
+	return value;
+}
+
+inline uint32 lz_hash(uint32 value)
+{
+	return (value * 2654435761u) >> (32 - lz_hash_bits);
+}
+
+inline uint8* lz_write_length(uint8* out, uint64 length)
+{
+	while (length >= 255)
+	{
+		*out++ = 255;
+		length -= 255;
+	}
+	*out++ = (uint8)length;
+	return out;
+}
+
+inline bool lz_read_length(const uint8*& in, const uint8* end, uint64& length)
+{
+	uint8 value;
+	do
+	{
+		if (in == end) return false;
+		value = *in++;
+		length += value;
+	} while (value == 255);
+	return true;
+}
+} // namespace detail
+
+// Compresses 'size' bytes from 'data' into 'out', which has room for 'capacity' bytes.
+// Returns the compressed size, or 0 if it didn't fit. With a capacity of at least
+// lz_compress_bound(size) it always fits.
+inline uint64 lz_compress(const uint8* data, uint64 size, uint8* out, uint64 capacity)
+{
+	assert(data && out);
+	// NOTE: the positions in the hash table are relative to 'data', so blocks up to 4 GB work.
+	uint32 table[1 << lz_hash_bits]{};
+	const uint8 *const end{ data + size };
+	const uint8 *const out_begin{ out };
+	const uint8 *const out_end{ out + capacity };
+	// Matches don't start in the last bytes, so that 4-byte reads stay in the data.
+	const uint8 *const match_limit{ size > lz_min_match ? end - lz_min_match : data };
+
+	const uint8* literals{ data };
+	const uint8* at{ data };
+	while (at < match_limit)
+	{
+		const uint32 value{ detail::lz_read32(at) };
+		const uint32 hash{ detail::lz_hash(value) };
+		const uint8 *const candidate{ data + table[hash] };
+		table[hash] = (uint32)(at - data);
+
+		if (candidate >= at || (uint64)(at - candidate) > lz_max_offset || detail::lz_read32(candidate) != value)
+		{
+			++at;
+			continue;
+		}
+
+		const uint8* match_end{ at + lz_min_match };
+		const uint8* candidate_end{ candidate + lz_min_match };
+		while (match_end < end && *match_end == *candidate_end)
+		{
+			++match_end;
+			++candidate_end;
+		}
+
+		const uint64 literal_count{ (uint64)(at - literals) };
+		const uint64 match_length{ (uint64)(match_end - at) - lz_min_match };
+		// token + literal length bytes + literals + offset + match length bytes
+		if ((uint64)(out_end - out) < 1 + literal_count / 255 + 1 + literal_count + 2 + match_length / 255 + 1) return 0;
+
+		uint8 *const token{ out++ };
+		*token = (uint8)((literal_count < 15 ? literal_count : 15) << 4);
+		if (literal_count >= 15) out = detail::lz_write_length(out, literal_count - 15);
+		memcpy(out, literals, literal_count); out += literal_count;
+
+		const uint16 offset{ (uint16)(at - candidate) };
+		memcpy(out, &offset, sizeof(offset)); out += sizeof(offset);
+		*token |= (uint8)(match_length < 15 ? match_length : 15);
+		if (match_length >= 15) out = detail::lz_write_length(out, match_length - 15);
+
+		at = match_end;
+		literals = at;
+	}
+
+	const uint64 literal_count{ (uint64)(end - literals) };
+	if ((uint64)(out_end - out) < 1 + literal_count / 255 + 1 + literal_count) return 0;
+	*out++ = (uint8)((literal_count < 15 ? literal_count : 15) << 4);
+	if (literal_count >= 15) out = detail::lz_write_length(out, literal_count - 15);
+	memcpy(out, literals, literal_count); out += literal_count;
+
+	return (uint64)(out - out_begin);
+}
+
+// Decompresses 'size' bytes of compressed data into 'out'. Returns false if the data is
+// broken or doesn't decompress to exactly 'out_size' bytes.
+inline bool lz_decompress(const uint8* data, uint64 size, uint8* out, uint64 out_size)
+{
+	assert(data && out);
+	const uint8* in{ data };
+	const uint8 *const in_end{ data + size };
+	uint8 *const out_begin{ out };
+	uint8 *const out_end{ out + out_size };
+
+	while (in < in_end)
+	{
+		const uint8 token{ *in++ };
+		uint64 literal_count{ (uint64)(token >> 4) };
+		if (literal_count == 15 && !detail::lz_read_length(in, in_end, literal_count)) return false;
+		if ((uint64)(in_end - in) < literal_count || (uint64)(out_end - out) < literal_count) return false;
+		memcpy(out, in, literal_count);
+		in += literal_count;
+		out += literal_count;
+
+		// The last sequence has no match.
+		if (in == in_end) break;
+
+		if ((uint64)(in_end - in) < sizeof(uint16)) return false;
+		uint16 offset;
+		memcpy(&offset, in, sizeof(offset)); in += sizeof(offset);
+		uint64 match_length{ (uint64)(token & 0xf) };
+		if (match_length == 15 && !detail::lz_read_length(in, in_end, match_length)) return false;
+		match_length += lz_min_match;
+
+		if (!offset || offset > (uint64)(out - out_begin) || (uint64)(out_end - out) < match_length) return false;
+		const uint8* match{ out - offset };
+		if (offset >= match_length)
+		{
+			memcpy(out, match, match_length);
+			out += match_length;
+		}
+		else
+		{
+			// Overlapping match: repeats the last 'offset' bytes.
+			for (uint64 i{ 0 }; i < match_length; ++i) *out++ = *match++;
+		}
+	}
+
+	return out == out_end;
+}
+
+}
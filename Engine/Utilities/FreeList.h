@@ -41,7 +41,7 @@ public:
 		else
 		{
 			id = _nextFreeIndex;
-			assert(id < _array.size() && !alreadeyRemoved(id));
+			assert(id < _array.size() && alreadeyRemoved(id));
 			_nextFreeIndex = *reinterpret_cast<const uint32*>(std::addressof(_array[id]));
 			new	(std::addressof(_array[id])) T{ std::forward<params>(p)... };
 		}
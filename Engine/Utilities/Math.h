@@ -3,6 +3,7 @@
 #pragma once
 #include "CommonHeaders.h"
 #include "MathTypes.h"
+#include <cmath>
 
 namespace zone::math {
 template<typename T>
@@ -21,7 +22,7 @@ constexpr uint32 packUnitFloat(float value)
 }
 
 template<uint32 bits>
-constexpr uint32 unpackToUnitFloat(uint32 i)
+constexpr float unpackToUnitFloat(uint32 i)
 {
 	static_assert(bits <= sizeof(uint32) * 8, "bits must be less than or equal to 32");
 	assert(i < (1ui32 << bits));
@@ -44,4 +45,95 @@ constexpr float unpackToFloat(uint32 i, float min, float max)
 	assert(min < max);
 	return unpackToUnitFloat<bits>(i) * (max - min) + min;
 }
+
+#ifdef _WIN64
+// Smallest-three quaternion compression: the largest component (in absolute value) is
+// dropped and rebuilt from the other three when unpacking. The sign of the quaternion is
+// flipped to make the dropped component positive (q and -q are the same rotation), so the
+// remaining three components are always in [-1/sqrt(2), 1/sqrt(2)].
+constexpr float smallestThreeRange{ 0.7071067811865475f };
+
+struct PackedQuaternion48
+{
+	// Each value stores one component in its low 15 bits. The top bits of the first two
+	// values hold the index of the dropped component.
+	uint16 data[3];
+};
+
+namespace detail {
+template<uint32 bits>
+uint32 packSmallestThree(const Vec4F& q, uint32 (&values)[3])
+{
+	const float c[4]{ q.x, q.y, q.z, q.w };
+	uint32 largest{ 0 };
+	for (uint32 i{ 1 }; i < 4; ++i)
+	{
+		if (std::abs(c[i]) > std::abs(c[largest])) largest = i;
+	}
+
+	const float sign{ c[largest] < 0.f ? -1.f : 1.f };
+	for (uint32 i{ 0 }, j{ 0 }; i < 4; ++i)
+	{
+		if (i == largest) continue;
+		const float v{ clamp(c[i] * sign, -smallestThreeRange, smallestThreeRange) };
+		values[j++] = packFloat<bits>(v, -smallestThreeRange, smallestThreeRange);
+	}
+
+	return largest;
+}
+
+template<uint32 bits>
+Vec4F unpackSmallestThree(uint32 largest, const uint32 (&values)[3])
+{
+	assert(largest < 4);
+	float c[4]{};
+	float sum{ 0.f };
+	for (uint32 i{ 0 }, j{ 0 }; i < 4; ++i)
+	{
+		if (i == largest) continue;
+		c[i] = unpackToFloat<bits>(values[j++], -smallestThreeRange, smallestThreeRange);
+		sum += c[i] * c[i];
+	}
+
+	const float remainder{ 1.f - sum };
+	c[largest] = remainder > 0.f ? std::sqrt(remainder) : 0.f;
+	return Vec4F{ &c[0] };
+}
+} // namespace detail
+
+// Packs a unit quaternion in 32 bits: 2 bits for the dropped component and 10 bits for
+// each of the other three.
+inline uint32 packQuaternion32(const Vec4F& q)
+{
+	uint32 values[3];
+	const uint32 largest{ detail::packSmallestThree<10>(q, values) };
+	return (largest << 30) | (values[0] << 20) | (values[1] << 10) | values[2];
+}
+
+inline Vec4F unpackQuaternion32(uint32 packed)
+{
+	const uint32 values[3]{ (packed >> 20) & 0x3ff, (packed >> 10) & 0x3ff, packed & 0x3ff };
+	return detail::unpackSmallestThree<10>(packed >> 30, values);
+}
+
+// Packs a unit quaternion in 48 bits: 2 bits for the dropped component and 15 bits for
+// each of the other three.
+inline PackedQuaternion48 packQuaternion48(const Vec4F& q)
+{
+	uint32 values[3];
+	const uint32 largest{ detail::packSmallestThree<15>(q, values) };
+	PackedQuaternion48 packed{};
+	packed.data[0] = (uint16)(((largest >> 1) << 15) | values[0]);
+	packed.data[1] = (uint16)(((largest & 1) << 15) | values[1]);
+	packed.data[2] = (uint16)values[2];
+	return packed;
+}
+
+inline Vec4F unpackQuaternion48(const PackedQuaternion48& packed)
+{
+	const uint32 largest{ (uint32)(((packed.data[0] >> 15) << 1) | (packed.data[1] >> 15)) };
+	const uint32 values[3]{ packed.data[0] & 0x7fffu, packed.data[1] & 0x7fffu, packed.data[2] & 0x7fffu };
+	return detail::unpackSmallestThree<15>(largest, values);
+}
+#endif // _WIN64
 } // namespace zone::math
\ No newline at end of file
@@ -0,0 +1,158 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+#pragma once
+#include "CommonHeaders.h"
+#include "Math.h"
+#include <emmintrin.h>
+
+#ifdef _WIN64
+namespace zone::math {
+
+// Returns the lanes of 'a' where 'mask' is set and the lanes of 'b' elsewhere.
+inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+inline __m128i select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// Packs 4 quaternions given as SoA lanes. Produces the same bits as packQuaternion32().
+inline __m128i packQuaternion32Lanes(__m128 x, __m128 y, __m128 z, __m128 w)
+{
+	const __m128 sign_mask{ _mm_set1_ps(-0.f) };
+	const __m128 ax{ _mm_andnot_ps(sign_mask, x) };
+	const __m128 ay{ _mm_andnot_ps(sign_mask, y) };
+	const __m128 az{ _mm_andnot_ps(sign_mask, z) };
+	const __m128 aw{ _mm_andnot_ps(sign_mask, w) };
+
+	// NOTE: same order and tie-breaking as detail::packSmallestThree().
+	__m128 largest_abs{ ax };
+	__m128 largest{ x };
+	__m128i index{ _mm_setzero_si128() };
+
+	__m128 mask{ _mm_cmpgt_ps(ay, largest_abs) };
+	largest_abs = select(mask, ay, largest_abs);
+	largest = select(mask, y, largest);
+	index = select(_mm_castps_si128(mask), _mm_set1_epi32(1), index);
+
+	mask = _mm_cmpgt_ps(az, largest_abs);
+	largest_abs = select(mask, az, largest_abs);
+	largest = select(mask, z, largest);
+	index = select(_mm_castps_si128(mask), _mm_set1_epi32(2), index);
+
+	mask = _mm_cmpgt_ps(aw, largest_abs);
+	largest = select(mask, w, largest);
+	index = select(_mm_castps_si128(mask), _mm_set1_epi32(3), index);
+
+	const __m128 flip{ _mm_and_ps(largest, sign_mask) };
+	x = _mm_xor_ps(x, flip);
+	y = _mm_xor_ps(y, flip);
+	z = _mm_xor_ps(z, flip);
+	w = _mm_xor_ps(w, flip);
+
+	const __m128 is0{ _mm_castsi128_ps(_mm_cmpeq_epi32(index, _mm_setzero_si128())) };
+	const __m128 below2{ _mm_castsi128_ps(_mm_cmplt_epi32(index, _mm_set1_epi32(2))) };
+	const __m128 below3{ _mm_castsi128_ps(_mm_cmplt_epi32(index, _mm_set1_epi32(3))) };
+	const __m128 a{ select(is0, y, x) };
+	const __m128 b{ select(below2, z, y) };
+	const __m128 c{ select(below3, w, z) };
+
+	const __m128 min{ _mm_set1_ps(-smallestThreeRange) };
+	const __m128 max{ _mm_set1_ps(smallestThreeRange) };
+	const __m128 range{ _mm_set1_ps(2.f * smallestThreeRange) };
+	const __m128 intervals{ _mm_set1_ps(1023.f) };
+	const __m128 half{ _mm_set1_ps(0.5f) };
+	auto quantize = [&](__m128 v)
+	{
+		v = _mm_min_ps(_mm_max_ps(v, min), max);
+		const __m128 distance{ _mm_div_ps(_mm_sub_ps(v, min), range) };
+		return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(distance, intervals), half));
+	};
+
+	__m128i packed{ _mm_slli_epi32(index, 30) };
+	packed = _mm_or_si128(packed, _mm_slli_epi32(quantize(a), 20));
+	packed = _mm_or_si128(packed, _mm_slli_epi32(quantize(b), 10));
+	packed = _mm_or_si128(packed, quantize(c));
+	return packed;
+}
+
+// Unpacks 4 quaternions packed with packQuaternion32() into SoA lanes.
+inline void unpackQuaternion32Lanes(__m128i packed, __m128& x, __m128& y, __m128& z, __m128& w)
+{
+	const __m128i mask10{ _mm_set1_epi32(0x3ff) };
+	const __m128i index{ _mm_srli_epi32(packed, 30) };
+
+	const __m128 min{ _mm_set1_ps(-smallestThreeRange) };
+	const __m128 range{ _mm_set1_ps(2.f * smallestThreeRange) };
+	const __m128 intervals{ _mm_set1_ps(1023.f) };
+	auto dequantize = [&](__m128i v)
+	{
+		const __m128 f{ _mm_cvtepi32_ps(_mm_and_si128(v, mask10)) };
+		return _mm_add_ps(_mm_mul_ps(_mm_div_ps(f, intervals), range), min);
+	};
+
+	const __m128 a{ dequantize(_mm_srli_epi32(packed, 20)) };
+	const __m128 b{ dequantize(_mm_srli_epi32(packed, 10)) };
+	const __m128 c{ dequantize(packed) };
+
+	const __m128 sum{ _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)), _mm_mul_ps(c, c)) };
+	const __m128 d{ _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(1.f), sum), _mm_setzero_ps())) };
+
+	const __m128 is0{ _mm_castsi128_ps(_mm_cmpeq_epi32(index, _mm_setzero_si128())) };
+	const __m128 is1{ _mm_castsi128_ps(_mm_cmpeq_epi32(index, _mm_set1_epi32(1))) };
+	const __m128 is2{ _mm_castsi128_ps(_mm_cmpeq_epi32(index, _mm_set1_epi32(2))) };
+	const __m128 is3{ _mm_castsi128_ps(_mm_cmpeq_epi32(index, _mm_set1_epi32(3))) };
+	const __m128 below2{ _mm_or_ps(is0, is1) };
+
+	x = select(is0, d, a);
+	y = select(is0, a, select(is1, d, b));
+	z = select(below2, b, select(is2, d, c));
+	w = select(is3, d, c);
+}
+
+// Packs 'count' quaternions with packQuaternion32(), 4 at a time.
+inline void packQuaternions32(const Vec4F *const in, uint32 *const out, uint32 count)
+{
+	uint32 i{ 0 };
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x{ _mm_loadu_ps(&in[i + 0].x) };
+		__m128 y{ _mm_loadu_ps(&in[i + 1].x) };
+		__m128 z{ _mm_loadu_ps(&in[i + 2].x) };
+		__m128 w{ _mm_loadu_ps(&in[i + 3].x) };
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_si128((__m128i*)&out[i], packQuaternion32Lanes(x, y, z, w));
+	}
+
+	for (; i < count; ++i)
+	{
+		out[i] = packQuaternion32(in[i]);
+	}
+}
+
+// Unpacks 'count' quaternions packed with packQuaternion32(), 4 at a time.
+inline void unpackQuaternions32(const uint32 *const in, Vec4F *const out, uint32 count)
+{
+	uint32 i{ 0 };
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x, y, z, w;
+		unpackQuaternion32Lanes(_mm_loadu_si128((const __m128i*)&in[i]), x, y, z, w);
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&out[i + 0].x, x);
+		_mm_storeu_ps(&out[i + 1].x, y);
+		_mm_storeu_ps(&out[i + 2].x, z);
+		_mm_storeu_ps(&out[i + 3].x, w);
+	}
+
+	for (; i < count; ++i)
+	{
+		out[i] = unpackQuaternion32(in[i]);
+	}
+}
+
+} // namespace zone::math
+#endif // _WIN64
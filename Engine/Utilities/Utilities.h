@@ -48,6 +48,24 @@ using deque = std::deque<T>;
 
 namespace zone::utl {
 
+// 64-bit FNV-1a hash of 'length' bytes, usable at compile time.
+constexpr uint64 hash_fnv1a(const char* data, uint64 length)
+{
+	uint64 hash{ 0xcbf2'9ce4'8422'2325ui64 };
+	for (uint64 i{ 0 }; i < length; ++i)
+	{
+		hash = (hash ^ (uint8)data[i]) * 0x0000'0100'0000'01b3ui64;
+	}
+	return hash;
+}
+
+// 64-bit FNV-1a hash of a null-terminated string.
+constexpr uint64 hash_fnv1a(const char* string)
+{
+	uint64 length{ 0 };
+	while (string[length]) ++length;
+	return hash_fnv1a(string, length);
+}
 }
 
 #include "FreeList.h"
\ No newline at end of file
@@ -21,7 +21,7 @@ using namespace zone;
 namespace {
 HMODULE game_code_dll{ nullptr };
 
-using _get_script_creator = zone::script::detail::script_creator(*)(size_t);
+using _get_script_creator = zone::script::detail::script_creator(*)(uint64);
 _get_script_creator get_script_creator{ nullptr };
 
 using _get_script_names = LPSAFEARRAY(*)(void);
@@ -57,7 +57,7 @@ EDITOR_INTERFACE uint32 UnloadGameCodeDll()
 
 EDITOR_INTERFACE script::detail::script_creator GetScriptCreator(const char* name)
 {
-	return (game_code_dll && get_script_creator) ? get_script_creator(script::detail::string_hash()(name)) : nullptr;
+	return (game_code_dll && get_script_creator) ? get_script_creator(script::detail::hash_script_name(name)) : nullptr;
 }
 
 EDITOR_INTERFACE LPSAFEARRAY GetScriptNames()
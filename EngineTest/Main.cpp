@@ -10,6 +10,10 @@
 #include "TestWindow.h"
 #elif TEST_RENDERER
 #include "TestRenderer.h"
+#elif TEST_BENCHMARKS
+#include "TestBenchmarks.h"
+#elif TEST_CONTENT
+#include "TestContent.h"
 #else
 #error One of the tests need to be enabled
 #endif
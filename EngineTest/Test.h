@@ -8,6 +8,8 @@
 #define TEST_ENTITY_COMPONENTS 0
 #define TEST_WINDOW 0
 #define TEST_RENDERER 1
+#define TEST_BENCHMARKS 0
+#define TEST_CONTENT 0
 
 class Test
 {
@@ -0,0 +1,559 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#pragma once
+#include "Test.h"
+#include "..\Engine\Components\Entity.h"
+#include "..\Engine\Components\Transform.h"
+#include "..\Engine\Components\Bounds.h"
+#include "..\Engine\Components\Script.h"
+#include "..\Engine\Core\JobSystem.h"
+#include "..\Engine\EngineAPI\ScriptSystems.h"
+
+#include <iostream>
+#include <algorithm>
+
+using namespace zone;
+
+// Moves its entity in update(), one script at a time.
+class benchmark_mover : public script::entity_script
+{
+public:
+	constexpr explicit benchmark_mover(game_entity::entity entity)
+		: script::entity_script{ entity } {}
+
+	void update(float dt) override
+	{
+		transform::component transform{ this->transform() };
+		math::Vec3F position{ transform.position() };
+		position.x += velocity * dt;
+		transform.set_position(position);
+	}
+
+	float velocity{ 1.f };
+};
+
+// Moves its entity from a script system, a whole batch at a time.
+class benchmark_system_mover : public script::entity_script
+{
+public:
+	constexpr explicit benchmark_system_mover(game_entity::entity entity)
+		: script::entity_script{ entity } {}
+
+	float velocity{ 1.f };
+};
+
+void move_system_movers(const script::system_batch<benchmark_system_mover>& batch, float dt)
+{
+	for (uint32 i{ 0 }; i < batch.count; ++i)
+	{
+		batch.positions[i].x += batch.scripts[i].velocity * dt;
+	}
+}
+
+REGISTER_SCRIPT(benchmark_mover);
+REGISTER_SCRIPT(benchmark_system_mover);
+REGISTER_SCRIPT_SYSTEM(benchmark_system_mover, move_system_movers, script::system_access::positions);
+
+// Frame time benchmarks of the entity systems. Each benchmark creates its own world, runs
+// a number of frames and prints the average time per frame. The checks compare the results
+// of the same systems with a brute-force version and count the mismatches.
+class EngineTest : public Test
+{
+public:
+	bool initialize() override
+	{
+		// NOTE: the same seed every time, so that runs can be compared.
+		srand(1);
+		return jobs::initialize();
+	}
+
+	void run() override
+	{
+		do {
+			check_bounds();
+			check_static_split();
+			print_checks();
+			benchmark_bounds_refit();
+			benchmark_static_split();
+			benchmark_script_systems();
+		} while (getchar() != 'q');
+	}
+
+	void shutdown() override
+	{
+		jobs::shutdown();
+	}
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	static constexpr float world_size{ 4000.f };
+	// NOTE: the checks use a small world, so that queries and rays hit many bounds.
+	static constexpr float check_world_size{ 200.f };
+	static constexpr uint32 check_rounds{ 10 };
+	static constexpr uint32 check_query_count{ 64 };
+	static constexpr float simulation_step{ 1.f / 30.f };
+	static constexpr uint32 warmup_frames{ 5 };
+	static constexpr uint32 measured_frames{ 30 };
+
+	struct world_layout
+	{
+		enum type : uint32
+		{
+			// All entities are dynamic.
+			dynamic,
+			// The moving entities are dynamic and are created first, the others are static.
+			static_contiguous,
+			// The moving entities are dynamic and are spread evenly among the static ones.
+			static_scattered,
+		};
+	};
+
+	// 1M bounds, of which a few thousand move every frame. Moving a little stays inside
+	// the fat boxes or refits the tree; teleporting forces the leaves to be reinserted.
+	void benchmark_bounds_refit()
+	{
+		constexpr uint32 entity_count{ 1'000'000 };
+		constexpr uint32 moving_count{ 3'000 };
+		create_world(entity_count, moving_count, world_layout::dynamic, world_size);
+
+		std::cout << "Bounds refit, " << entity_count << " bounds, " << moving_count << " moving\n";
+		std::cout << "  steady moves: " << run_bounds_frames(false) << " ms\n";
+		std::cout << "  teleports:    " << run_bounds_frames(true) << " ms\n";
+
+		destroy_world();
+	}
+
+	// A large static level with a few moving entities. Only the dynamic entities cost time
+	// per frame, and they cost less when their ids are contiguous.
+	void benchmark_static_split()
+	{
+		constexpr uint32 static_count{ 2'000'000 };
+		constexpr uint32 moving_count{ 20'000 };
+		std::cout << "Static split, " << static_count << " static and " << moving_count << " moving entities\n";
+
+		create_world(static_count + moving_count, moving_count, world_layout::static_contiguous, world_size);
+		std::cout << "  contiguous: " << run_frames() << " ms\n";
+		destroy_world();
+
+		create_world(static_count + moving_count, moving_count, world_layout::static_scattered, world_size);
+		std::cout << "  scattered:  " << run_frames() << " ms\n";
+		destroy_world();
+	}
+
+	// Moves, removes and adds bounds at random for a number of frames. After each frame the
+	// results of bounds queries and raycasts must be the same as with a linear scan.
+	void check_bounds()
+	{
+		constexpr uint32 entity_count{ 20'000 };
+		constexpr uint32 moving_count{ 2'000 };
+		constexpr uint32 replaced_count{ 500 };
+		create_world(entity_count, moving_count, world_layout::dynamic, check_world_size);
+
+		for (uint32 round{ 0 }; round < check_rounds; ++round)
+		{
+			// NOTE: steady moves refit the tree, teleports reinsert the leaves and removing and
+			//		 adding entities rebalances it.
+			move_entities(round & 1);
+			replace_entities(replaced_count, world_layout::dynamic);
+			end_frame();
+			check_queries();
+		}
+
+		destroy_world();
+	}
+
+	// A world of static entities with a few moving ones spread among them. Moving the dynamic
+	// entities must not change the static ones, and queries must find the bounds in both the
+	// static tree, which is built in one go by median split, and the dynamic tree.
+	void check_static_split()
+	{
+		constexpr uint32 entity_count{ 20'000 };
+		constexpr uint32 moving_count{ 2'000 };
+		constexpr uint32 replaced_count{ 500 };
+		create_world(entity_count, moving_count, world_layout::static_scattered, check_world_size);
+		check_queries();
+
+		for (uint32 round{ 0 }; round < check_rounds; ++round)
+		{
+			transform::begin_simulation_step();
+			move_entities(round & 1);
+			transform::update_world_matrices(0.5f);
+
+			// NOTE: the static entities were all created in earlier frames, so none of them
+			//		 may be in this frame's changes.
+			const transform::transform_id *const changed_ids{ transform::get_changed_ids() };
+			for (uint32 i{ 0 }; i < transform::changed_count(); ++i)
+			{
+				check(!transform::component{ changed_ids[i] }.is_static());
+			}
+
+			bounds::update();
+			transform::publish_snapshot();
+			transform::clear_changes();
+			check_static_transforms();
+
+			// New static entities are inserted into the static tree one at a time.
+			replace_entities(replaced_count, world_layout::static_scattered);
+			end_frame();
+			check_queries();
+		}
+
+		destroy_world();
+	}
+
+	// The world matrix of each static entity must be the one of its position, since they're
+	// created with no rotation and a scale of 1.
+	void check_static_transforms()
+	{
+		for (uint32 i{ 0 }; i < _entities.size(); ++i)
+		{
+			const transform::component transform{ _entities[i].transform() };
+			if (_is_moving[i])
+			{
+				check(!transform.is_static());
+				continue;
+			}
+
+			const math::Vec3F p{ transform.position() };
+			const math::Mat3x4F m{ transform.world_matrix() };
+			check(transform.is_static() &&
+				  m._11 == 1.f && m._12 == 0.f && m._13 == 0.f && m._14 == p.x &&
+				  m._21 == 0.f && m._22 == 1.f && m._23 == 0.f && m._24 == p.y &&
+				  m._31 == 0.f && m._32 == 0.f && m._33 == 1.f && m._34 == p.z);
+		}
+	}
+
+	// Runs random box and sphere queries and raycasts and compares their results with a linear
+	// scan of the world bounds of all entities.
+	void check_queries()
+	{
+		utl::vector<bounds::component> all_bounds;
+		for (uint32 i{ 0 }; i < _entities.size(); ++i)
+		{
+			all_bounds.emplace_back(_entities[i].bounds());
+		}
+
+		bounds::aabb boxes[check_query_count];
+		bounds::sphere spheres[check_query_count];
+		bounds::ray rays[check_query_count];
+		for (uint32 i{ 0 }; i < check_query_count; ++i)
+		{
+			const math::Vec3F min{ random_position() };
+			const float size{ random(5.f, 40.f) };
+			boxes[i] = { min, { min.x + size, min.y + size, min.z + size } };
+			spheres[i] = { random_position(), random(5.f, 30.f) };
+			rays[i] = { random_position(), { random(-1.f, 1.f), random(-1.f, 1.f), random(-1.f, 1.f) }, random(10.f, 300.f) };
+		}
+
+		utl::vector<bounds::component> results;
+		utl::vector<uint32> offsets;
+		bounds::query_aabbs(&boxes[0], check_query_count, results, offsets);
+		for (uint32 i{ 0 }; i < check_query_count; ++i)
+		{
+			check(is_same_result(results, offsets, i, all_bounds, [&](const bounds::aabb& box) { return overlaps(box, boxes[i]); }));
+		}
+
+		bounds::query_spheres(&spheres[0], check_query_count, results, offsets);
+		for (uint32 i{ 0 }; i < check_query_count; ++i)
+		{
+			check(is_same_result(results, offsets, i, all_bounds, [&](const bounds::aabb& box) { return overlaps(box, spheres[i]); }));
+		}
+
+		bounds::ray_hit hits[check_query_count];
+		bounds::raycast(&rays[0], check_query_count, &hits[0]);
+		for (uint32 i{ 0 }; i < check_query_count; ++i)
+		{
+			const bounds::ray& r{ rays[i] };
+			float closest{ -1.f };
+			for (uint32 j{ 0 }; j < all_bounds.size(); ++j)
+			{
+				const float distance{ intersect(all_bounds[j].world_bounds(), r) };
+				if (distance >= 0.f && (closest < 0.f || distance < closest)) closest = distance;
+			}
+
+			// NOTE: two bounds can be hit at the same distance, so only the distances are compared.
+			const bounds::ray_hit& hit{ hits[i] };
+			check(hit.bounds.is_valid() == (closest >= 0.f) &&
+				  (!hit.bounds.is_valid() || std::abs(hit.distance - closest) <= 1e-4f * (1.f + closest)));
+		}
+	}
+
+	// Returns true if query 'index' found the same bounds as 'test' finds in 'all_bounds'.
+	template<typename test_func>
+	static bool is_same_result(const utl::vector<bounds::component>& results, const utl::vector<uint32>& offsets, uint32 index,
+							   const utl::vector<bounds::component>& all_bounds, test_func test)
+	{
+		utl::vector<uint32> found;
+		for (uint32 i{ offsets[index] }; i < offsets[index + 1]; ++i)
+		{
+			found.emplace_back(id::index(results[i].get_id()));
+		}
+
+		utl::vector<uint32> expected;
+		for (uint32 i{ 0 }; i < all_bounds.size(); ++i)
+		{
+			if (test(all_bounds[i].world_bounds())) expected.emplace_back(id::index(all_bounds[i].get_id()));
+		}
+
+		if (found.size() != expected.size()) return false;
+		std::sort(found.data(), found.data() + found.size());
+		std::sort(expected.data(), expected.data() + expected.size());
+		return !found.size() || !memcmp(found.data(), expected.data(), found.size() * sizeof(uint32));
+	}
+
+	static bool overlaps(const bounds::aabb& a, const bounds::aabb& b)
+	{
+		return a.min.x <= b.max.x && a.min.y <= b.max.y && a.min.z <= b.max.z &&
+			   a.max.x >= b.min.x && a.max.y >= b.min.y && a.max.z >= b.min.z;
+	}
+
+	static bool overlaps(const bounds::aabb& box, const bounds::sphere& s)
+	{
+		const math::Vec3F closest{ std::clamp(s.center.x, box.min.x, box.max.x),
+								   std::clamp(s.center.y, box.min.y, box.max.y),
+								   std::clamp(s.center.z, box.min.z, box.max.z) };
+		const float dx{ s.center.x - closest.x }, dy{ s.center.y - closest.y }, dz{ s.center.z - closest.z };
+		return dx * dx + dy * dy + dz * dz <= s.radius * s.radius;
+	}
+
+	// Returns the distance at which 'r' enters 'box', or a negative value when it misses.
+	static float intersect(const bounds::aabb& box, const bounds::ray& r)
+	{
+		const float origin[3]{ r.origin.x, r.origin.y, r.origin.z };
+		const float direction[3]{ r.direction.x, r.direction.y, r.direction.z };
+		const float min[3]{ box.min.x, box.min.y, box.min.z };
+		const float max[3]{ box.max.x, box.max.y, box.max.z };
+		float t_min{ 0.f };
+		float t_max{ r.max_distance };
+		for (uint32 i{ 0 }; i < 3; ++i)
+		{
+			const float t0{ (min[i] - origin[i]) / direction[i] };
+			const float t1{ (max[i] - origin[i]) / direction[i] };
+			t_min = std::max(t_min, std::min(t0, t1));
+			t_max = std::min(t_max, std::max(t0, t1));
+		}
+		return t_min <= t_max ? t_min : -1.f;
+	}
+
+	void check(bool is_ok)
+	{
+		assert(is_ok);
+		++_checks;
+		if (!is_ok) ++_check_errors;
+	}
+
+	void print_checks()
+	{
+		std::cout << "Checks: " << _checks << ", failed: " << _check_errors << "\n";
+	}
+
+	// Scripts that move their entity every step, updated one by one through update() or in
+	// batches by a script system.
+	void benchmark_script_systems()
+	{
+		constexpr uint32 script_count{ 50'000 };
+		std::cout << "Script systems, " << script_count << " moving scripts\n";
+		std::cout << "  update():      " << run_script_frames("benchmark_mover", script_count) << " ms\n";
+		std::cout << "  script system: " << run_script_frames("benchmark_system_mover", script_count) << " ms\n";
+	}
+
+	// Creates 'count' entities with a script of the type 'script_name' and returns the average
+	// time of script::update() per step, in milliseconds.
+	float run_script_frames(const char* script_name, uint32 count)
+	{
+		script::init_info script_info{ script::detail::get_script_creator(script::detail::hash_script_name(script_name)) };
+		assert(script_info.script_creator);
+		transform::init_info transform_info{};
+		transform_info.rotation[3] = 1.f;
+		game_entity::entity_info entity_info{ &transform_info, &script_info };
+
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			game_entity::entity entity{ game_entity::create(entity_info) };
+			assert(entity.is_valid());
+			_entities.emplace_back(entity);
+		}
+		end_frame();
+
+		float total{ 0.f };
+		for (uint32 frame{ 0 }; frame < warmup_frames + measured_frames; ++frame)
+		{
+			const clock::time_point start{ clock::now() };
+			script::update(simulation_step, script::tick_group::pre_physics);
+			if (frame >= warmup_frames) total += milliseconds_since(start);
+			end_frame();
+		}
+
+		destroy_world();
+		return total / measured_frames;
+	}
+
+	// Returns the average time of a whole frame, with a simulation step, interpolation,
+	// bounds and the snapshot, in milliseconds.
+	float run_frames()
+	{
+		float total{ 0.f };
+		for (uint32 frame{ 0 }; frame < warmup_frames + measured_frames; ++frame)
+		{
+			const clock::time_point start{ clock::now() };
+			transform::begin_simulation_step();
+			move_entities(false);
+			end_frame(0.5f);
+			if (frame >= warmup_frames) total += milliseconds_since(start);
+		}
+
+		return total / measured_frames;
+	}
+
+	// Returns the average time of bounds::update() per frame, in milliseconds.
+	float run_bounds_frames(bool is_teleport)
+	{
+		float total{ 0.f };
+		for (uint32 frame{ 0 }; frame < warmup_frames + measured_frames; ++frame)
+		{
+			move_entities(is_teleport);
+			transform::update_world_matrices();
+
+			const clock::time_point start{ clock::now() };
+			bounds::update();
+			if (frame >= warmup_frames) total += milliseconds_since(start);
+
+			transform::publish_snapshot();
+			transform::clear_changes();
+		}
+
+		return total / measured_frames;
+	}
+
+	void move_entities(bool is_teleport)
+	{
+		for (uint32 i{ 0 }; i < _moving_ids.size(); ++i)
+		{
+			math::Vec3F& position{ _positions[i] };
+			if (is_teleport)
+			{
+				position = random_position();
+			}
+			else
+			{
+				position.x += _velocities[i].x;
+				position.y += _velocities[i].y;
+				position.z += _velocities[i].z;
+			}
+		}
+
+		transform::set_positions({ _moving_ids.data(), _moving_ids.size() }, { _positions.data(), _positions.size() });
+	}
+
+	// Creates 'count' entities with a unit box at random positions in a cube of 'size'.
+	// 'moving_count' of them are moved by the benchmarks, which ones depends on 'layout'.
+	void create_world(uint32 count, uint32 moving_count, world_layout::type layout, float size)
+	{
+		_world_size = size;
+		const uint32 stride{ count / moving_count };
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			const math::Vec3F position{ random_position() };
+			const bool is_moving{ layout == world_layout::static_scattered ?
+				!(i % stride) && _moving_ids.size() < moving_count : i < moving_count };
+			const game_entity::entity entity{ create_entity(position, layout != world_layout::dynamic && !is_moving) };
+			_is_moving.emplace_back(is_moving);
+
+			if (is_moving)
+			{
+				_moving_ids.emplace_back(entity.transform().get_id());
+				_positions.emplace_back(position);
+				_velocities.emplace_back(random(-0.3f, 0.3f), random(-0.3f, 0.3f), random(-0.3f, 0.3f));
+			}
+		}
+
+		end_frame();
+	}
+
+	game_entity::entity create_entity(const math::Vec3F& position, bool is_static)
+	{
+		transform::init_info transform_info{};
+		memcpy(&transform_info.position[0], &position.x, sizeof(transform_info.position));
+		transform_info.rotation[3] = 1.f;
+		transform_info.is_static = is_static;
+		bounds::init_info bounds_info{};
+		game_entity::entity_info entity_info{ &transform_info, nullptr, &bounds_info };
+		const game_entity::entity entity{ game_entity::create(entity_info) };
+		assert(entity.is_valid());
+		_entities.emplace_back(entity);
+		return entity;
+	}
+
+	// Removes 'count' random entities that don't move and creates as many new ones, which
+	// get the ids of the removed ones once enough ids are free.
+	void replace_entities(uint32 count, world_layout::type layout)
+	{
+		uint32 removed{ 0 };
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			const uint32 index{ (uint32)rand() % (uint32)_entities.size() };
+			if (_is_moving[index]) continue;
+			game_entity::remove(_entities[index].get_id());
+			_entities.erase_unordered(index);
+			_is_moving.erase_unordered(index);
+			++removed;
+		}
+
+		for (uint32 i{ 0 }; i < removed; ++i)
+		{
+			create_entity(random_position(), layout != world_layout::dynamic);
+			_is_moving.emplace_back(0);
+		}
+	}
+
+	void destroy_world()
+	{
+		for (uint32 i{ 0 }; i < _entities.size(); ++i)
+		{
+			game_entity::remove(_entities[i].get_id());
+		}
+
+		_entities.clear();
+		_is_moving.clear();
+		_moving_ids.clear();
+		_positions.clear();
+		_velocities.clear();
+		end_frame();
+	}
+
+	// The per-frame work of the engine after the simulation steps.
+	void end_frame(float alpha = 1.f)
+	{
+		transform::update_world_matrices(alpha);
+		bounds::update();
+		transform::publish_snapshot();
+		transform::clear_changes();
+	}
+
+	static float random(float min, float max)
+	{
+		return min + (max - min) * ((float)rand() / (float)RAND_MAX);
+	}
+
+	math::Vec3F random_position() const
+	{
+		return { random(0.f, _world_size), random(0.f, _world_size), random(0.f, _world_size) };
+	}
+
+	static float milliseconds_since(clock::time_point start)
+	{
+		return std::chrono::duration<float, std::milli>(clock::now() - start).count();
+	}
+
+	utl::vector<game_entity::entity>		_entities;
+	// 1 for the entities in '_entities' that are moved by the benchmarks.
+	utl::vector<uint8>						_is_moving;
+	utl::vector<transform::transform_id>	_moving_ids;
+	utl::vector<math::Vec3F>				_positions;
+	utl::vector<math::Vec3F>				_velocities;
+	float									_world_size{ world_size };
+	uint32									_checks{ 0 };
+	uint32									_check_errors{ 0 };
+};
@@ -0,0 +1,350 @@
+// Copyright (c) CedricZ1, 2025
+// Distributed under the MIT license. See the LICENSE file in the project root for more information.
+
+#pragma once
+#include "Test.h"
+#include "..\Engine\Content\Package.h"
+#include "..\Engine\Core\JobSystem.h"
+#include "..\Engine\Platform\AsyncIO.h"
+#include "..\Engine\Utilities\Compression.h"
+
+#include <iostream>
+#include <cstdio>
+
+using namespace zone;
+
+// Checks the LZ codec and the package reader. The codec round-trips random, zero-filled and
+// periodic data and must reject broken input without writing past its output. The package
+// reader must reject broken directories and blocks, with and without async I/O.
+class EngineTest : public Test
+{
+public:
+	bool initialize() override
+	{
+		// NOTE: the same seed every time, so that failures can be reproduced.
+		srand(1);
+		return jobs::initialize();
+	}
+
+	void run() override
+	{
+		do {
+			_checks = 0;
+			_check_errors = 0;
+			check_codec();
+			check_package();
+			// NOTE: the second pass reads the packages with the async I/O service running.
+			if (platform::initializeAsyncIO())
+			{
+				check_package();
+				platform::shutdownAsyncIO();
+			}
+			std::cout << "Checks: " << _checks << ", failed: " << _check_errors << "\n";
+		} while (getchar() != 'q');
+	}
+
+	void shutdown() override
+	{
+		jobs::shutdown();
+	}
+
+private:
+	enum data_kind : uint32
+	{
+		random_data,
+		zero_filled,
+		periodic,
+		mixed,
+
+		kind_count
+	};
+
+	// Written after the output of lz_decompress(), which must stay untouched.
+	static constexpr uint8 guard_value{ 0xcd };
+	static constexpr uint32 guard_size{ 64 };
+	static constexpr const char* package_path{ "test_content.pak" };
+	static constexpr uint32 block_size{ content::package_min_block_size };
+
+	void check_codec()
+	{
+		constexpr uint32 sizes[]{ 0, 1, 3, 4, 5, 15, 16, 19, 255, 256, 270, 4096, 65'535, 65'536, 65'537, 300'000 };
+		for (uint32 kind{ 0 }; kind < kind_count; ++kind)
+		{
+			for (uint32 size : sizes)
+			{
+				make_data((data_kind)kind, size, _data);
+				check_round_trip(_data);
+			}
+		}
+	}
+
+	void check_round_trip(const utl::vector<uint8>& data)
+	{
+		const uint64 size{ data.size() };
+		const uint8 *const source{ size ? data.data() : &guard_value };
+		_packed.resize(utl::lz_compress_bound(size));
+		const uint64 packed_size{ utl::lz_compress(source, size, _packed.data(), _packed.size()) };
+		check(packed_size && packed_size <= _packed.size());
+		_packed.resize(packed_size);
+
+		check(decompress(_packed.data(), packed_size, size) && equals(data));
+		// The output size must match exactly.
+		if (size) check(!decompress(_packed.data(), packed_size, size - 1));
+		check(!decompress(_packed.data(), packed_size, size + 1));
+
+		// With less room than it needs, lz_compress() returns 0 and stays inside the buffer.
+		if (size)
+		{
+			_scratch.resize(packed_size - 1 + guard_size);
+			memset(_scratch.data(), guard_value, _scratch.size());
+			check(!utl::lz_compress(source, size, _scratch.data(), packed_size - 1));
+			bool is_guard_intact{ true };
+			for (uint64 i{ packed_size - 1 }; i < _scratch.size(); ++i) is_guard_intact &= _scratch[i] == guard_value;
+			check(is_guard_intact);
+		}
+
+		// Broken input may decompress to anything, but it must not write past the output.
+		// Data cut short can only decompress when it still gives all of 'size' bytes.
+		for (uint64 cut{ 1 }; cut <= 16 && cut <= packed_size; ++cut)
+		{
+			if (decompress(_packed.data(), packed_size - cut, size)) check(equals(data));
+		}
+
+		for (uint32 i{ 0 }; i < 32 && packed_size; ++i)
+		{
+			_scratch.resize(packed_size);
+			memcpy(_scratch.data(), _packed.data(), packed_size);
+			_scratch[random_index(packed_size)] ^= (uint8)(1 + rand() % 255);
+			decompress(_scratch.data(), packed_size, size);
+		}
+	}
+
+	// Decompresses into '_output' and checks the guard bytes after it.
+	bool decompress(const uint8* data, uint64 size, uint64 output_size)
+	{
+		_output.resize(output_size + guard_size);
+		memset(_output.data(), guard_value, _output.size());
+		const bool succeeded{ utl::lz_decompress(data, size, _output.data(), output_size) };
+		bool is_guard_intact{ true };
+		for (uint64 i{ output_size }; i < _output.size(); ++i) is_guard_intact &= _output[i] == guard_value;
+		check(is_guard_intact);
+		return succeeded;
+	}
+
+	bool equals(const utl::vector<uint8>& data) const
+	{
+		return !data.size() || !memcmp(_output.data(), data.data(), data.size());
+	}
+
+	static uint64 random_index(uint64 count)
+	{
+		return ((uint64)rand() * ((uint64)RAND_MAX + 1) + (uint64)rand()) % count;
+	}
+
+	static void make_data(data_kind kind, uint64 size, utl::vector<uint8>& data)
+	{
+		data.resize(size);
+		const uint32 period{ 1 + (uint32)(rand() % 300) };
+		for (uint64 i{ 0 }; i < size; ++i)
+		{
+			switch (kind)
+			{
+			case random_data: data[i] = (uint8)rand(); break;
+			case zero_filled: data[i] = 0; break;
+			case periodic: data[i] = (uint8)((i % period) * 7); break;
+			// Runs of random bytes and repeats, like most real files.
+			case mixed: data[i] = (i / 512) % 2 ? (uint8)rand() : (uint8)(i % period); break;
+			default: break;
+			}
+		}
+	}
+
+	// Builds a package with a few files in memory, then writes broken copies of it and
+	// checks that package::open() or package::read() fails for each of them.
+	void check_package()
+	{
+		constexpr uint64 file_sizes[]{ 3 * block_size + 1000, block_size, 1, 200 };
+		constexpr data_kind file_kinds[]{ mixed, periodic, random_data, random_data };
+		constexpr uint32 file_count{ _countof(file_sizes) };
+		utl::vector<uint8> files[file_count]{};
+		for (uint32 i{ 0 }; i < file_count; ++i) make_data(file_kinds[i], file_sizes[i], files[i]);
+		make_package(files, file_count, _package);
+
+		check(write_file(_package) && check_files(files, file_count));
+
+		using namespace content;
+		package_header& header{ *(package_header*)_package.data() };
+		package_file *const directory{ (package_file*)(_package.data() + sizeof(package_header)) };
+		package_block *const blocks{ (package_block*)(directory + file_count) };
+
+		// The header.
+		check_broken(header.magic, header.magic + 1);
+		check_broken(header.version, package_version + 1);
+		check_broken(header.block_size, package_min_block_size - 1);
+		check_broken(header.block_size, package_max_block_size + 1);
+		check_broken(header.file_count, 1'000'000u);
+		check_broken(header.block_count, 1'000'000u);
+
+		// The files.
+		check_broken(directory[1].name_hash, directory[0].name_hash);
+		check_broken(directory[0].first_block, header.block_count);
+		check_broken(directory[0].block_count, directory[0].block_count + 1);
+		check_broken(directory[0].size, directory[0].size + 1);
+
+		// The blocks.
+		const uint32 first{ directory[0].first_block };
+		check_broken(blocks[first].size, blocks[first].size - 1);
+		check_broken(blocks[first].size, block_size + 1);
+		check_broken(blocks[first].offset, (uint64)_package.size());
+		check_broken(blocks[first].compressed_size, blocks[first].size + 1);
+
+		// A package cut short.
+		check(write_file(_package, sizeof(package_header) - 1) && !open_package());
+		check(write_file(_package, sizeof(package_header) + sizeof(package_file)) && !open_package());
+		check(write_file(_package, _package.size() - 1) && !open_package());
+
+		// Broken compressed data opens, but the file can't be read. A zero-filled block starts
+		// with a match at offset 0, which is never valid.
+		uint32 checked_blocks{ 0 };
+		for (uint32 i{ 0 }; i < header.block_count; ++i)
+		{
+			const package_block block{ blocks[i] };
+			if (block.compressed_size == block.size) continue;
+			uint32 index{ 0 };
+			while (directory[index].first_block + directory[index].block_count <= i) ++index;
+
+			_scratch.resize(block.compressed_size);
+			memcpy(_scratch.data(), &_package[block.offset], block.compressed_size);
+			memset(&_package[block.offset], 0, block.compressed_size);
+			check(write_file(_package) && read_fails(index));
+			memcpy(&_package[block.offset], _scratch.data(), block.compressed_size);
+			++checked_blocks;
+		}
+		check(checked_blocks != 0);
+
+		std::remove(package_path);
+	}
+
+	// Writes a copy of the package with 'field' set to 'value' and checks that it can't be
+	// opened. Then puts the old value back.
+	template<typename T, typename U>
+	void check_broken(T& field, U value)
+	{
+		const T old_value{ field };
+		field = (T)value;
+		check(write_file(_package) && !open_package());
+		field = old_value;
+	}
+
+	bool check_files(const utl::vector<uint8>* files, uint32 file_count)
+	{
+		content::package package{};
+		if (!package.open(package_path) || package.file_count() != file_count) return false;
+		bool is_ok{ package.find("missing") == uint32_invalid_id };
+		for (uint32 i{ 0 }; i < file_count; ++i)
+		{
+			char name[16];
+			sprintf_s(name, "file%u", i);
+			const uint32 index{ package.find(name) };
+			if (index == uint32_invalid_id || package.file_size(index) != files[i].size()) return false;
+
+			_output.resize(files[i].size() + guard_size);
+			memset(_output.data(), guard_value, _output.size());
+			is_ok &= package.read(index, _output.data()) && equals(files[i]);
+			for (uint64 b{ files[i].size() }; b < _output.size(); ++b) is_ok &= _output[b] == guard_value;
+		}
+		return is_ok;
+	}
+
+	bool open_package()
+	{
+		content::package package{};
+		return package.open(package_path);
+	}
+
+	bool read_fails(uint32 index)
+	{
+		content::package package{};
+		if (!package.open(package_path)) return false;
+		_output.resize(package.file_size(index));
+		return !package.read(index, _output.data());
+	}
+
+	// Writes a package the same way tools::PackFiles() does. The engine doesn't link the
+	// content tools, so the layout is built here from PackageFormat.h.
+	void make_package(const utl::vector<uint8>* files, uint32 file_count, utl::vector<uint8>& package)
+	{
+		using namespace content;
+		utl::vector<uint64> name_hashes(file_count);
+		utl::vector<uint32> order(file_count);
+		uint32 block_count{ 0 };
+		for (uint32 i{ 0 }; i < file_count; ++i)
+		{
+			char name[16];
+			sprintf_s(name, "file%u", i);
+			name_hashes[i] = hash_package_name(name);
+			order[i] = i;
+			block_count += (uint32)((files[i].size() + block_size - 1) / block_size);
+		}
+
+		for (uint32 i{ 1 }; i < file_count; ++i)
+		{
+			for (uint32 j{ i }; j && name_hashes[order[j - 1]] > name_hashes[order[j]]; --j) std::swap(order[j - 1], order[j]);
+		}
+
+		const uint64 directory_size{ sizeof(package_header) + file_count * sizeof(package_file) + block_count * sizeof(package_block) };
+		package.resize(directory_size);
+		package_header header{ package_magic, package_version, block_size, file_count, block_count, {} };
+		memcpy(package.data(), &header, sizeof(header));
+
+		uint32 block_index{ 0 };
+		for (uint32 i{ 0 }; i < file_count; ++i)
+		{
+			const utl::vector<uint8>& file{ files[order[i]] };
+			const uint32 file_blocks{ (uint32)((file.size() + block_size - 1) / block_size) };
+			const package_file entry{ name_hashes[order[i]], file.size(), block_index, file_blocks };
+			memcpy(package.data() + sizeof(package_header) + i * sizeof(package_file), &entry, sizeof(entry));
+
+			for (uint32 b{ 0 }; b < file_blocks; ++b, ++block_index)
+			{
+				const uint64 offset{ (uint64)b * block_size };
+				const uint32 size{ (uint32)(file.size() - offset < block_size ? file.size() - offset : block_size) };
+				_packed.resize(utl::lz_compress_bound(size));
+				uint64 packed_size{ utl::lz_compress(file.data() + offset, size, _packed.data(), size - 1) };
+				const uint8 *const data{ packed_size ? _packed.data() : file.data() + offset };
+				if (!packed_size) packed_size = size;
+
+				const package_block block{ package.size(), (uint32)packed_size, size };
+				memcpy(package.data() + sizeof(package_header) + file_count * sizeof(package_file) + block_index * sizeof(package_block), &block, sizeof(block));
+				const uint64 at{ package.size() };
+				package.resize(at + packed_size);
+				memcpy(package.data() + at, data, packed_size);
+			}
+		}
+	}
+
+	static bool write_file(const utl::vector<uint8>& data, uint64 size = ~0ull)
+	{
+		if (size > data.size()) size = data.size();
+		FILE* file{ nullptr };
+		if (fopen_s(&file, package_path, "wb") || !file) return false;
+		const bool succeeded{ fwrite(data.data(), 1, size, file) == size };
+		fclose(file);
+		return succeeded;
+	}
+
+	void check(bool is_ok)
+	{
+		assert(is_ok);
+		++_checks;
+		if (!is_ok) ++_check_errors;
+	}
+
+	utl::vector<uint8>						_data;
+	utl::vector<uint8>						_packed;
+	utl::vector<uint8>						_scratch;
+	utl::vector<uint8>						_output;
+	utl::vector<uint8>						_package;
+	uint32									_checks{ 0 };
+	uint32									_check_errors{ 0 };
+};
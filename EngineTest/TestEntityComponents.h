@@ -5,6 +5,8 @@
 #include "Test.h"
 #include "..\Engine\Components\Entity.h"
 #include "..\Engine\Components\Transform.h"
+#include "..\Engine\Content\WorldSnapshot.h"
+#include "..\Engine\Utilities\MathSIMD.h"
 
 #include <iostream>
 #include <ctime>
@@ -29,6 +31,8 @@ public:
 				remove_random();
 				_num_entities = (uint32)_entities.size();
 			}
+			check_rotations();
+			check_snapshot();
 			print_results();
 		} while (getchar() != 'q');
 	}
@@ -88,10 +92,97 @@ private:
 		}
 	}
 
+	// Writes random rotations to the entities with the batched API and reads them back. The
+	// SIMD batch packing must give the same bits as packing one quaternion at a time.
+	void check_rotations()
+	{
+		const uint32 count{ (uint32)_entities.size() };
+		utl::vector<transform::transform_id> ids(count);
+		utl::vector<math::Vec4F> rotations(count);
+		utl::vector<math::Vec4F> read(count);
+		utl::vector<uint32> packed(count);
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			ids[i] = _entities[i].transform().get_id();
+			rotations[i] = random_rotation();
+		}
+
+		bool is_same{ true };
+		math::packQuaternions32(rotations.data(), packed.data(), count);
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			is_same &= packed[i] == math::packQuaternion32(rotations[i]);
+		}
+
+		math::unpackQuaternions32(packed.data(), read.data(), count);
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			is_same &= is_near(read[i], math::unpackQuaternion32(packed[i]), 1e-6f);
+		}
+
+		transform::set_rotations({ ids.data(), count }, { rotations.data(), count });
+		transform::get_rotations({ ids.data(), count }, { read.data(), count });
+		for (uint32 i{ 0 }; i < count; ++i)
+		{
+			// NOTE: compressed rotations are only kept to about 0.25 degrees.
+			const math::Vec4F rotation{ _entities[i].transform().rotation() };
+			is_same &= is_near(read[i], rotation, 1e-6f) && is_near(rotation, rotations[i], USE_COMPRESSED_ROTATIONS ? 4e-3f : 0.f);
+		}
+
+		assert(is_same);
+		++_rotation_checks;
+		if (!is_same) ++_rotation_errors;
+	}
+
+	static math::Vec4F random_rotation()
+	{
+		using namespace DirectX;
+		const XMVECTOR angles{ XMVectorSet(random_angle(), random_angle(), random_angle(), 0.f) };
+		math::Vec4F rotation;
+		XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYawFromVector(angles));
+		return rotation;
+	}
+
+	static float random_angle()
+	{
+		return ((float)rand() / (float)RAND_MAX * 2.f - 1.f) * math::pi;
+	}
+
+	// Compares two quaternions, which are the same rotation when one is the other negated.
+	static bool is_near(const math::Vec4F& a, const math::Vec4F& b, float epsilon)
+	{
+		const float sign{ a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.f ? -1.f : 1.f };
+		return std::abs(a.x - sign * b.x) <= epsilon && std::abs(a.y - sign * b.y) <= epsilon &&
+			   std::abs(a.z - sign * b.z) <= epsilon && std::abs(a.w - sign * b.w) <= epsilon;
+	}
+
+	// Saves the world, restores it and saves it again. Both snapshots must be the same and
+	// all entities must still be alive.
+	void check_snapshot()
+	{
+		utl::vector<uint8> saved;
+		content::save_world(saved);
+		bool is_same{ content::restore_world(saved.data(), saved.size()) };
+
+		utl::vector<uint8> resaved;
+		content::save_world(resaved);
+		is_same &= saved.size() == resaved.size() && !memcmp(saved.data(), resaved.data(), saved.size());
+		for (uint32 i{ 0 }; i < _entities.size(); ++i)
+		{
+			is_same &= game_entity::is_alive(_entities[i].get_id());
+		}
+
+		assert(is_same);
+		++_snapshots;
+		if (!is_same) ++_snapshot_errors;
+	}
+
 	void print_results()
 	{
 		std::cout << "Entities created: " << _added << "\n";
 		std::cout << "Entities deleted: " << _removed << "\n";
+		std::cout << "Rotation checks: " << _rotation_checks << ", failed: " << _rotation_errors << "\n";
+		std::cout << "Snapshot round trips: " << _snapshots << ", failed: " << _snapshot_errors << "\n";
 	}
 
 	utl::vector<game_entity::entity> _entities;
@@ -99,4 +190,8 @@ private:
 	uint32 _added{ 0 };
 	uint32 _removed{ 0 };
 	uint32 _num_entities{ 0 };
+	uint32 _rotation_checks{ 0 };
+	uint32 _rotation_errors{ 0 };
+	uint32 _snapshots{ 0 };
+	uint32 _snapshot_errors{ 0 };
 };
@@ -77,6 +77,21 @@ namespace ZoneEditor.Components
             }
         }
 
+        private bool _isStatic;
+        [DataMember]
+        public bool IsStatic
+        {
+            get => _isStatic;
+            set
+            {
+                if (_isStatic != value)
+                {
+                    _isStatic = value;
+                    OnPropertyChanged(nameof(IsStatic));
+                }
+            }
+        }
+
         private string _name;
         [DataMember]
         public string Name
@@ -164,6 +179,21 @@ namespace ZoneEditor.Components
                 }
             }
 
+        private bool? _isStatic;
+
+        public bool? IsStatic
+            {
+                get => _isStatic;
+                set
+                {
+                    if (_isStatic != value)
+                    {
+                        _isStatic = value;
+                        OnPropertyChanged(nameof(IsStatic));
+                    }
+                }
+            }
+
         private string _name;
 
         public string Name
@@ -228,6 +258,7 @@ namespace ZoneEditor.Components
             switch (propertyName)
             {
                 case nameof(IsEnabled): SelectedEntities.ForEach(x => x.IsEnabled = IsEnabled.Value); return true;
+                case nameof(IsStatic): SelectedEntities.ForEach(x => x.IsStatic = IsStatic.Value); return true;
                 case nameof(Name): SelectedEntities.ForEach(x => x.Name = Name); return true;
             }
             return false;
@@ -236,6 +267,7 @@ namespace ZoneEditor.Components
         protected virtual bool UpdateMSGameEntity()
         {
             IsEnabled = GetMixedValue(SelectedEntities, new Func<GameEntity, bool>(x => x.IsEnabled));
+            IsStatic = GetMixedValue(SelectedEntities, new Func<GameEntity, bool>(x => x.IsStatic));
             Name = GetMixedValue(SelectedEntities, new Func<GameEntity, string>(x => x.Name));
 
             return true;
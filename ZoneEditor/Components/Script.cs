@@ -36,6 +36,17 @@ namespace ZoneEditor.Components
             bw.Write(nameBytes);
         }
 
+        // 64-bit FNV-1a hash of a script name. Must match script::detail::hash_script_name() in the engine.
+        public static ulong HashName(string name)
+        {
+            ulong hash = 0xcbf29ce484222325;
+            foreach (var b in Encoding.UTF8.GetBytes(name))
+            {
+                hash = (hash ^ b) * 0x00000100000001b3;
+            }
+            return hash;
+        }
+
         public Script(GameEntity owner) : base(owner)  { }
     }
 
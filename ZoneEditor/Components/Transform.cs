@@ -63,10 +63,14 @@ namespace ZoneEditor.Components
         }
         public override IMSComponent GetMultiselectionComponent(MSEntity msEntity) => new MSTransform(msEntity);
 
+        // NOTE: writes a transform record of the game.bin transforms section (version 2 and up).
+        //       Files without a version store the rotation as Euler angles instead.
         public override void WriteToBinary(BinaryWriter bw)
         {
             bw.Write(_position.X); bw.Write(_position.Y); bw.Write(_position.Z);
-            bw.Write(_rotation.X); bw.Write(_rotation.Y); bw.Write(_rotation.Z);
+            var rotation = Quaternion.CreateFromYawPitchRoll(_rotation.Y, _rotation.X, _rotation.Z);
+            foreach (var value in MathUtil.PackQuaternion48(rotation)) bw.Write(value);
+            bw.Write((ushort)0); // pads the record to 32 bytes
             bw.Write(_scale.X); bw.Write(_scale.Y); bw.Write(_scale.Z);
         }
 
@@ -57,6 +57,34 @@ namespace ZoneEditor.ContentToolsAPIStructs
         }
     }
 
+    [StructLayout(LayoutKind.Sequential)]
+    struct PackageFile
+    {
+        public IntPtr Name;
+        public IntPtr Data;
+        public uint Size;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    class PackageData : IDisposable
+    {
+        public IntPtr Files;
+        public uint FileCount;
+        public uint BlockSize; // 0 uses the default block size
+        public IntPtr Buffer;
+        public uint BufferSize;
+
+        public void Dispose()
+        {
+            Marshal.FreeCoTaskMem(Buffer);
+            GC.SuppressFinalize(this);
+        }
+        ~PackageData()
+        {
+            Dispose();
+        }
+    }
+
     [StructLayout(LayoutKind.Sequential)]
     class PrimitiveInitInfo
     {
@@ -76,6 +104,9 @@ namespace ZoneEditor.DllWrappers
     {
         private const string _toolsDLL = "ContentTools.dll";
 
+        [DllImport(_toolsDLL, CharSet = CharSet.Ansi)]
+        public static extern void SetContentCacheDirectory(string path);
+
         [DllImport(_toolsDLL)]
         private static extern void CreatePrimitiveMesh([In, Out] SceneData data, PrimitiveInitInfo info);
 
@@ -99,5 +130,49 @@ namespace ZoneEditor.DllWrappers
             }
         }
 
+        [DllImport(_toolsDLL)]
+        private static extern void PackFiles([In, Out] PackageData data);
+
+        // Packs the files into one package for the engine (see PackageFormat.h). Returns null on failure.
+        public static byte[] PackFiles(IList<(string name, byte[] data)> files)
+        {
+            Debug.Assert(files?.Any() == true);
+            var entrySize = Marshal.SizeOf<PackageFile>();
+            var handles = new List<GCHandle>();
+            var names = new List<IntPtr>();
+            using var packageData = new PackageData() { FileCount = (uint)files.Count };
+            packageData.Files = Marshal.AllocHGlobal(entrySize * files.Count);
+            try
+            {
+                for (int i = 0; i < files.Count; ++i)
+                {
+                    var handle = GCHandle.Alloc(files[i].data, GCHandleType.Pinned);
+                    handles.Add(handle);
+                    var name = Marshal.StringToHGlobalAnsi(files[i].name);
+                    names.Add(name);
+                    var file = new PackageFile() { Name = name, Data = handle.AddrOfPinnedObject(), Size = (uint)files[i].data.Length };
+                    Marshal.StructureToPtr(file, packageData.Files + i * entrySize, false);
+                }
+
+                PackFiles(packageData);
+                Debug.Assert(packageData.Buffer != IntPtr.Zero && packageData.BufferSize > 0);
+                var package = new byte[packageData.BufferSize];
+                Marshal.Copy(packageData.Buffer, package, 0, package.Length);
+                return package;
+            }
+            catch (Exception ex)
+            {
+                Logger.Log(MessageType.Error, "Failed to pack the game files.");
+                Debug.WriteLine(ex.Message);
+                return null;
+            }
+            finally
+            {
+                handles.ForEach(x => x.Free());
+                names.ForEach(x => Marshal.FreeHGlobal(x));
+                Marshal.FreeHGlobal(packageData.Files);
+            }
+        }
+
     }
 }
\ No newline at end of file
@@ -76,6 +76,17 @@ namespace ZoneEditor.Editors
             });
         }
 
+        private Action GetIsStaticAction()
+        {
+            var viewModel = DataContext as MSEntity;
+            var selection = viewModel.SelectedEntities.Select(entity => (entity, entity.IsStatic)).ToList();
+            return new Action(() =>
+            {
+                selection.ForEach(item => item.entity.IsStatic = item.IsStatic);
+                (DataContext as MSEntity).Refresh();
+            });
+        }
+
         private void OnName_TextBox_GotKeyboardFocus(object sender, KeyboardFocusChangedEventArgs e)
         {
             _propertyName = string.Empty;
@@ -103,6 +114,16 @@ namespace ZoneEditor.Editors
                 viewModel.IsEnabled == true ? "Enable game entity" : "Disable game entity"));
         }
 
+        private void OnIsStatic_CheckBox_Click(object sender, RoutedEventArgs e)
+        {
+            var undoAction = GetIsStaticAction();
+            var viewModel = DataContext as MSEntity;
+            viewModel.IsStatic = (sender as CheckBox).IsChecked == true;
+            var redoAction = GetIsStaticAction();
+            Project.UndoRedo.Add(new UndoRedoAction(undoAction, redoAction,
+                viewModel.IsStatic == true ? "Make game entity static" : "Make game entity dynamic"));
+        }
+
         private void OnAddComponent_Button_PreviewMouse_LBD(object sender, MouseButtonEventArgs e)
         {
             var menu = FindResource("addComponentMenu") as ContextMenu;
@@ -183,24 +183,125 @@ namespace ZoneEditor.GameProject
             Logger.Log(MessageType.Info, $"Project saved to {project.FullPath}");
         }
 
+        // NOTE: game.bin v2 layout, read by ContentLoader.cpp in the engine: a header, a section
+        //       table and the sections, each starting on a 16-byte boundary.
+        private enum GameBinSection : uint
+        {
+            Entities,
+            Transforms,
+            Scripts,
+            Names, // only in version 2 files
+        }
+
+        private const uint GameBinMagic = 0x3242475A; // "ZGB2"
+        private const uint GameBinVersion = 3;
+        private const uint InvalidIndex = uint.MaxValue;
+        private const ushort InvalidScriptIndex = ushort.MaxValue;
+
+        private static long AlignGameBin(long offset) => (offset + 15) & ~15L;
+
         private void SaveToBinary()
         {
             var configName = GetConfigurationName(StandAloneBuildConfig);
             var bin = $@"{Path}x64\{configName}\game.bin";
 
-            using (var bw = new BinaryWriter(File.Open(bin, FileMode.Create, FileAccess.Write)))
+            using var entities = new MemoryStream();
+            using var transforms = new MemoryStream();
+            using var scripts = new MemoryStream();
+            var entityWriter = new BinaryWriter(entities);
+            var transformWriter = new BinaryWriter(transforms);
+            var scriptWriter = new BinaryWriter(scripts);
+
+            // Transforms are written as one block. Each script type is written once, as the hash
+            // of its name, and the entities refer to it by index.
+            var scriptIndices = new Dictionary<string, ushort>();
+            uint transformCount = 0;
+            foreach (var entity in ActiveScene.GameEntities)
             {
-                bw.Write(ActiveScene.GameEntities.Count);
-                foreach (var entity in ActiveScene.GameEntities)
+                uint componentMask = 0, transformIndex = InvalidIndex;
+                ushort scriptIndex = InvalidScriptIndex;
+                foreach (var component in entity.Components)
                 {
-                    bw.Write(0); //entity type
-                    bw.Write(entity.Components.Count);
-                    foreach (var component in entity.Components)
+                    componentMask |= 1u << (int)component.ToEnumType();
+                    switch (component)
                     {
-                        bw.Write((int)component.ToEnumType());
-                        component.WriteToBinary(bw);
+                        case Transform transform:
+                            transformIndex = transformCount++;
+                            transform.WriteToBinary(transformWriter);
+                            break;
+                        case Script script:
+                            if (!scriptIndices.TryGetValue(script.Name, out scriptIndex))
+                            {
+                                Debug.Assert(scriptIndices.Count < InvalidScriptIndex);
+                                scriptIndex = (ushort)scriptIndices.Count;
+                                scriptIndices.Add(script.Name, scriptIndex);
+                                scriptWriter.Write(Script.HashName(script.Name));
+                            }
+                            break;
                     }
                 }
+
+                entityWriter.Write(entity.IsStatic ? 1u : 0u); //entity type flags: 0x01 = static
+                entityWriter.Write(componentMask);
+                entityWriter.Write(transformIndex);
+                entityWriter.Write(scriptIndex);
+                entityWriter.Write((ushort)0);
+            }
+
+            var sections = new (GameBinSection type, uint count, MemoryStream data)[]
+            {
+                (GameBinSection.Entities, (uint)ActiveScene.GameEntities.Count, entities),
+                (GameBinSection.Transforms, transformCount, transforms),
+                (GameBinSection.Scripts, (uint)scriptIndices.Count, scripts),
+            };
+
+            using (var bw = new BinaryWriter(File.Open(bin, FileMode.Create, FileAccess.Write)))
+            {
+                bw.Write(GameBinMagic);
+                bw.Write(GameBinVersion);
+                bw.Write((uint)ActiveScene.GameEntities.Count);
+                bw.Write((uint)sections.Length);
+
+                var offset = AlignGameBin(16 + 16 * sections.Length);
+                foreach (var (type, count, data) in sections)
+                {
+                    bw.Write((uint)type);
+                    bw.Write(count);
+                    bw.Write((uint)offset);
+                    bw.Write((uint)data.Length);
+                    offset = AlignGameBin(offset + data.Length);
+                }
+
+                foreach (var (_, _, data) in sections)
+                {
+                    while (bw.BaseStream.Position != AlignGameBin(bw.BaseStream.Position)) bw.Write((byte)0);
+                    bw.Write(data.GetBuffer(), 0, (int)data.Length);
+                }
+            }
+        }
+
+        // NOTE: the engine reads the game files from game.pak and only reads the loose files
+        //       that aren't in it (see ContentLoader.cpp). So, a package that couldn't be
+        //       written is deleted, rather than left behind with old files.
+        private void SaveToPackage()
+        {
+            var configName = GetConfigurationName(StandAloneBuildConfig);
+            var directory = $@"{Path}x64\{configName}\";
+            var pak = directory + "game.pak";
+
+            var files = new List<(string name, byte[] data)>()
+            {
+                ("game.bin", File.ReadAllBytes(directory + "game.bin")),
+            };
+
+            var package = ContentToolsAPI.PackFiles(files);
+            if (package != null)
+            {
+                File.WriteAllBytes(pak, package);
+            }
+            else if (File.Exists(pak))
+            {
+                File.Delete(pak);
             }
         }
 
@@ -211,6 +312,7 @@ namespace ZoneEditor.GameProject
             if (VisualStudio.BuildSucceeded)
             {
                 SaveToBinary();
+                SaveToPackage();
                 await Task.Run(() => VisualStudio.Run(this, configName, debug));
             }
         }
@@ -274,6 +376,9 @@ namespace ZoneEditor.GameProject
             ActiveScene = Scenes.FirstOrDefault(x => x.IsActive);
             Debug.Assert(ActiveScene != null);
 
+            // Packed meshes are cached per project, so unchanged meshes aren't processed again.
+            ContentToolsAPI.SetContentCacheDirectory($@"{Path}.Zone\ContentCache\");
+
             await BuildGameCodeDll(false);
 
             SetCommands();
@@ -2,6 +2,7 @@
 using System.Collections.Generic;
 using System.Diagnostics.Contracts;
 using System.Linq;
+using System.Numerics;
 using System.Text;
 using System.Threading.Tasks;
 using System.Windows.Threading;
@@ -27,6 +28,31 @@ namespace ZoneEditor.Utilities
             if (!value.HasValue || !other.HasValue) return false;
             return Math.Abs(value.Value - other.Value) < Epsilon;
         }
+
+        // Smallest-three quaternion packing in 48 bits. Must match math::packQuaternion48() in the engine.
+        public static ushort[] PackQuaternion48(Quaternion q)
+        {
+            const float range = 0.7071067811865475f;
+            var c = new float[] { q.X, q.Y, q.Z, q.W };
+            var largest = 0;
+            for (int i = 1; i < 4; ++i)
+            {
+                if (Math.Abs(c[i]) > Math.Abs(c[largest])) largest = i;
+            }
+
+            var sign = c[largest] < 0.0f ? -1.0f : 1.0f;
+            var values = new ushort[3];
+            for (int i = 0, j = 0; i < 4; ++i)
+            {
+                if (i == largest) continue;
+                var v = Math.Clamp(c[i] * sign, -range, range);
+                values[j++] = (ushort)((v + range) / (2.0f * range) * 32767.0f + 0.5f);
+            }
+
+            values[0] |= (ushort)((largest >> 1) << 15);
+            values[1] |= (ushort)((largest & 1) << 15);
+            return values;
+        }
     }
 
     class DelayEventTimerArgs : EventArgs